@@ -0,0 +1,149 @@
+// This example feeds a known audio signal through an AudioAnalyzer using a simulated clock, and checks the results:
+// a 2kHz tone should give the most energy in the band containing 2kHz, and 100Hz kick drum hits at 120 BPM should be
+// detected as beats, with a tempo estimate close to 120 BPM.
+// When built for a host (e.g. Linux) with AUDIO_WAV_FILE defined as the path of a 16 bit mono PCM WAV file, the file is
+// analysed instead, and the tempo is checked against AUDIO_WAV_BPM (if defined).
+// Does not require any LEDs or microphone to be connected
+#include <FastLED.h>
+#include <LEDuino.h>
+
+#define SAMPLE_RATE 10000     // Sample rate of synthesised signal (in Hz)
+#define FRAME_DELAY 20        // Time between analyzer updates (in ms)
+#define NUM_FRAMES 500        // Number of frames to analyse (10 seconds)
+#define SIGNAL_BPM 120        // Tempo of kick drum hits in synthesised signal
+#define TONE_FREQ 2000        // Frequency of constant tone in synthesised signal (in Hz)
+#define BPM_TOLERANCE 5       // Maximum difference of estimated tempo from signal tempo
+
+#if defined(AUDIO_WAV_FILE) && (defined(__unix__) || defined(__APPLE__))
+  #include <stdio.h>
+  #include <string.h>
+  #define USE_WAV_FILE
+#endif
+
+AudioAnalyzer<128> analyzer;
+
+#ifdef USE_WAV_FILE
+FILE* wav_file = nullptr;
+
+// Open WAV file and skip to the sample data. Returns sample rate, or 0 if the file is not 16 bit mono PCM
+uint32_t openWav(const char* path) {
+  wav_file = fopen(path, "rb");
+  if (wav_file == nullptr) return 0;
+  uint8_t header[12];
+  if (fread(header, 1, 12, wav_file) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4)) return 0;
+  uint32_t sample_rate = 0;
+  // Read chunks until the data chunk, getting the format from the fmt chunk
+  uint8_t chunk[8];
+  while (fread(chunk, 1, 8, wav_file) == 8) {
+    uint32_t chunk_len = chunk[4] | (chunk[5] << 8) | ((uint32_t) chunk[6] << 16) | ((uint32_t) chunk[7] << 24);
+    if (!memcmp(chunk, "data", 4)) {
+      return sample_rate;
+    }
+    if (!memcmp(chunk, "fmt ", 4) && chunk_len >= 16) {
+      uint8_t format[16];
+      if (fread(format, 1, 16, wav_file) != 16) return 0;
+      uint16_t channels = format[2] | (format[3] << 8);
+      uint16_t bits = format[14] | (format[15] << 8);
+      if (format[0] != 1 || format[1] != 0 || channels != 1 || bits != 16) return 0;
+      sample_rate = format[4] | (format[5] << 8) | ((uint32_t) format[6] << 16) | ((uint32_t) format[7] << 24);
+      chunk_len -= 16;
+    }
+    // Chunks are padded to an even length
+    fseek(wav_file, chunk_len + (chunk_len & 1), SEEK_CUR);
+  }
+  return 0;
+}
+#endif
+
+// Get sample n of the synthesised signal: a constant tone, and a decaying 100Hz sine wave at the start of every beat
+int16_t synthSample(uint32_t n) {
+  float t = (float) n / SAMPLE_RATE;
+  float beat_t = fmod(t, 60.0/SIGNAL_BPM);
+  float kick = 20000*exp(-beat_t/0.04)*sin(2*PI*100*beat_t);
+  float tone = 3000*sin(2*PI*TONE_FREQ*t);
+  return kick + tone;
+}
+
+// Print result of check and return 1 if it failed
+uint8_t check(const char* name, bool pass) {
+  Serial.print(name);
+  Serial.println(pass ? ": PASS" : ": FAIL");
+  return pass ? 0 : 1;
+}
+
+void setup() {
+  Serial.begin(115200);
+  uint32_t sample_rate = SAMPLE_RATE;
+#ifdef USE_WAV_FILE
+  sample_rate = openWav(AUDIO_WAV_FILE);
+  if (sample_rate == 0) {
+    Serial.println("Could not read " AUDIO_WAV_FILE " (must be 16 bit mono PCM)");
+    return;
+  }
+#endif
+  uint32_t sample_num = 0;
+  uint16_t num_beats = 0;
+  uint32_t band_totals[LEDUINO_AUDIO_BANDS] = {};
+  for (uint16_t frame=0; frame < NUM_FRAMES; frame++) {
+    // Add the samples since the last frame, as they would be added by an ADC interrupt
+    uint32_t frame_end = (uint32_t) (frame + 1)*FRAME_DELAY*sample_rate/1000;
+    for (; sample_num < frame_end; sample_num++) {
+#ifdef USE_WAV_FILE
+      uint8_t bytes[2] = {};
+      fread(bytes, 1, 2, wav_file);
+      analyzer.addSample((int16_t) (bytes[0] | (bytes[1] << 8)));
+#else
+      analyzer.addSample(synthSample(sample_num));
+#endif
+    }
+    analyzer.update((uint32_t) (frame + 1)*FRAME_DELAY);
+    for (uint8_t b=0; b < LEDUINO_AUDIO_BANDS; b++) {
+      band_totals[b] += audio_snapshot.bands[b];
+    }
+    if (audio_snapshot.beat) {
+      num_beats++;
+    }
+  }
+
+  Serial.print("Average band energy:");
+  uint8_t loudest_band = 2;
+  for (uint8_t b=0; b < LEDUINO_AUDIO_BANDS; b++) {
+    Serial.print(" ");
+    Serial.print(band_totals[b]/NUM_FRAMES);
+    // Loudest band above the bands used for beat detection
+    if (b > 2 && band_totals[b] > band_totals[loudest_band]) {
+      loudest_band = b;
+    }
+  }
+  Serial.println();
+  Serial.print("Beats: ");
+  Serial.print(num_beats);
+  Serial.print(", tempo: ");
+  Serial.print(audio_snapshot.bpm);
+  Serial.println(" BPM");
+
+  uint8_t failures = 0;
+#ifdef USE_WAV_FILE
+  fclose(wav_file);
+  #ifdef AUDIO_WAV_BPM
+  failures += check("Tempo", abs(audio_snapshot.bpm - AUDIO_WAV_BPM) <= BPM_TOLERANCE);
+  #endif
+#else
+  // Band containing the tone frequency (bins are SAMPLE_RATE/128 Hz wide, see AudioAnalyzer band edges)
+  uint8_t tone_band = 0;
+  uint16_t tone_bin = (uint32_t) TONE_FREQ*128/SAMPLE_RATE;
+  while (tone_band < LEDUINO_AUDIO_BANDS - 1 && (uint16_t) (pow(64, (tone_band + 1.0)/LEDUINO_AUDIO_BANDS) + 0.5) <= tone_bin) {
+    tone_band++;
+  }
+  failures += check("Tone in expected band", loudest_band == tone_band);
+  // One beat per beat period (the first may be missed while the average is settling)
+  uint16_t expected_beats = (uint32_t) NUM_FRAMES*FRAME_DELAY*SIGNAL_BPM/60000;
+  failures += check("Beats detected", num_beats >= expected_beats - 1 && num_beats <= expected_beats);
+  failures += check("Tempo", abs(audio_snapshot.bpm - SIGNAL_BPM) <= BPM_TOLERANCE);
+#endif
+  Serial.print("Failures: ");
+  Serial.println(failures);
+}
+
+void loop() {
+}
@@ -0,0 +1,48 @@
+// This example displays pixel data streamed from a PC over serial using the Adalight protocol (e.g. from Prismatik or Hyperion),
+// with the stream downsampled onto two segments of the LED strip. 
+// For Art-Net or E1.31 over a network, replace the AdalightSource with ArtNetSource or E131Source and provide a UDP instance
+// (e.g. EthernetUDP or WiFiUDP) which is listening on port 6454 (Art-Net) or 5568 (E1.31)
+#include <FastLED.h>
+#include <LEDuino.h>
+
+#define LED_DATA_PIN 2
+#define NUM_LEDS 120
+#define SEGMENT_LEN 60
+// Number of pixels sent by the sequencer
+#define NUM_STREAM_PIXELS 120
+
+CRGB leds[NUM_LEDS];
+
+// Received pixel data is decoded directly into the pattern pixel array
+CRGB pixel_data[NUM_STREAM_PIXELS];
+
+// Define segments, first one is reversed (from the centre of the strip back to LED 0) so stream is mirrored from the centre of the strip
+StripSegment first_segment(SEGMENT_LEN, SEGMENT_LEN, NUM_LEDS, true);
+StripSegment second_segment(SEGMENT_LEN, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment_array[2] = {first_segment, second_segment};
+
+// Receive Adalight frames on the USB serial port
+AdalightSource adalight(Serial);
+// Hold the last received frame for 5 seconds if data stops
+ExternalStreamPattern stream_pattern(adalight, 5000);
+
+LinearPatternMapper stream_mapping(stream_pattern, pixel_data, NUM_STREAM_PIXELS, segment_array, 2);
+
+// Run frames every 10ms so that serial data is read quickly
+MappingRunner mappings[1] = {
+  MappingRunner(stream_mapping, 10)
+};
+
+LEDuinoController controller(leds, NUM_LEDS, mappings, 1, false);
+
+void setup() {
+  Serial.begin(115200);
+  FastLED.addLeds<NEOPIXEL, LED_DATA_PIN>(leds, NUM_LEDS).setCorrection(TypicalLEDStrip);
+  // Only one mapping configuration so don't need to change it
+  controller.auto_change_pattern = false;
+  controller.initialise();
+}
+
+void loop() {
+  controller.loop();
+}
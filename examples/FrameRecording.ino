@@ -0,0 +1,398 @@
+// This example renders every built-in pattern and mapper for a fixed number of frames using a simulated clock and
+// fixed random seed, and prints a hash of the rendered frames. The output is identical on every run, so the hashes can be
+// pasted into golden_hashes[] below to detect any change in rendered output (e.g. when optimising patterns or mappers).
+// Mappings which should render the same frames in different ways are also checked to be within a bounded error of each other.
+// Does not require any LEDs to be connected
+#define USE_GET_MILLISECOND_TIMER  // Make FastLED beatX() functions use the simulated clock
+#include <FastLED.h>
+#include <LEDuino.h>
+#include <Simulator.h>
+
+#define NUM_LEDS 60
+#define SEGMENT_LEN 30
+#define NUM_PIXELS 48
+#define NUM_FRAMES 500
+#define HP_BRIGHTNESS 128      // Brightness of high precision recordings
+#define NUM_COMPARE_FRAMES 100  // Frames compared by bounded error checks (uses NUM_COMPARE_FRAMES*NUM_LEDS*3 bytes of RAM)
+
+CRGB leds[NUM_LEDS];
+CRGB pixel_data[NUM_PIXELS];
+CRGB pixel_data2[NUM_PIXELS];
+CRGB pixel_data3[NUM_PIXELS];
+CRGB pixel_data4[NUM_PIXELS];
+CRGB matrix_pixel_data[NUM_LEDS];
+CRGB layer_buffers[4][NUM_LEDS];
+CRGB reference_frames[NUM_COMPARE_FRAMES*NUM_LEDS];
+// 16 bit LED and pixel arrays for the high precision pipeline
+CRGB16 leds16[NUM_LEDS];
+CRGB16 pixel_data16[NUM_PIXELS];
+
+// Segments
+StripSegment first_segment(0, SEGMENT_LEN, NUM_LEDS);
+StripSegment second_segment(SEGMENT_LEN, SEGMENT_LEN, NUM_LEDS, true);
+StripSegment segment_array[2] = {first_segment, second_segment};
+StripSegment first_segment_array[1] = {first_segment};
+StripSegment second_segment_array[1] = {second_segment};
+
+SpatialStripSegment<SEGMENT_LEN> spatial_segment1(first_segment, Point(-100, -100, 0), Point(100, 100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment2(second_segment, Point(-100, 100, 0), Point(100, -100, 0));
+SpatialStripSegment_T* spatial_segments[2] = {&spatial_segment1, &spatial_segment2};
+
+// 10x6 matrix made of 2x2 serpentine panels of 5x3 LEDs
+uint16_t matrix_table[NUM_LEDS];
+MatrixLayout matrix_layout(matrix_table, 5, 3, MATRIX_SERPENTINE | MATRIX_FLIP_Y, 2, 2);
+
+// Deterministic stand-in for a network or serial sequencer: sends a moving gradient on 3 of every 4 frames,
+// then stops after 300 frames so that the stream pattern holds the last frame and blacks out
+class TestFrameSource : public FrameSource {
+  public:
+    void reset() override {
+      this->frames = 0;
+    }
+
+    bool receive(CRGB* pixel_data, uint16_t num_pixels) override {
+      this->frames++;
+      if (this->frames > 300 || (this->frames & 3) == 0) {
+        return false;
+      }
+      for (uint16_t i=0; i < num_pixels; i++) {
+        pixel_data[i] = CRGB(i*5 + this->frames, 255 - i*5, this->frames*3);
+      }
+      return true;
+    }
+
+  protected:
+    uint16_t frames=0;
+};
+TestFrameSource test_source;
+
+// Patterns
+RandomColorFadePattern fade_pattern;
+PridePattern pride_pattern;
+RandomRainbowsPattern rainbows_pattern;
+GrowThenShrinkPattern grow_pattern;
+MovingPulsePattern pulse_pattern(6);
+DiscoStrobePattern disco_pattern;
+SkippingSpikePattern spike_pattern(6);
+// Twinkle pixel parameters are stored in a table instead of being regenerated every frame
+TwinkleParameters twinkle_parameters[NUM_PIXELS];
+TwinklePattern twinkle_pattern(6, 4, FairyLight_picker, CRGB::Black, twinkle_parameters, NUM_PIXELS);
+SparkleFillPattern sparkle_pattern;
+FirePattern<NUM_PIXELS> fire_pattern;
+GrowingSpherePattern sphere_pattern(4);
+DiagonalRainbowPattern rainbow_matrix_pattern;
+ExternalStreamPattern stream_pattern(test_source, 1000);
+// Ring with a ball on one side, smoothly blended together
+SDFTorus sdf_ring(Point(0, 0, 0), 200, 24);
+SDFSphere sdf_ball(Point(200, 0, 0), 80);
+SDFSmoothUnion sdf_ring_and_ball(sdf_ring, sdf_ball, 60);
+SDFPattern sdf_pattern(sdf_ring_and_ball, 80, false, 2, RainbowColors_picker);
+// Tilted plane with a capsule cut out of it
+SDFPlane sdf_plane(Point(1, 1, 0), Point(0, 0, 0));
+SDFCapsule sdf_capsule(Point(-150, 150, 0), Point(150, -150, 0), 40);
+SDFSubtract sdf_cut_plane(sdf_plane, sdf_capsule);
+SDFPattern sdf_plane_pattern(sdf_cut_plane, 64, true, 1, HalloweenColors_picker);
+// Patterns which move in steps of a fixed time instead of one step per frame
+MovingPulsePattern timed_pulse_pattern(6, Basic_picker, 25);
+RandomRainbowsPattern timed_rainbows_pattern(30);
+
+// Mappers (the pixel array length is used as pattern resolution, which is not a multiple of the segment length
+// so that the general interpolation case is covered)
+LinearPatternMapper fade_mapping(fade_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper pride_mapping(pride_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper rainbows_mapping(rainbows_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper grow_mapping(grow_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper pulse_mapping(pulse_pattern, pixel_data, SEGMENT_LEN, segment_array, 2);
+LinearPatternMapper disco_mapping(disco_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper spike_mapping(spike_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper twinkle_mapping(twinkle_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper sparkle_mapping(sparkle_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearToSpatialPatternMapper fire_mapping(fire_pattern, pixel_data, NUM_PIXELS, Point(0, 1, 0), spatial_segments, 2);
+SpatialPatternMapper sphere_mapping(sphere_pattern, spatial_segments, 2);
+// Pattern coordinates of the spatial segment LEDs are pre-calculated (output is identical to calculating them every frame)
+PointBuffer<NUM_LEDS> sphere_points;
+MatrixPatternMapper rainbow_matrix_mapping(rainbow_matrix_pattern, matrix_pixel_data, matrix_layout);
+LinearPatternMapper stream_mapping(stream_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+// Rotated through the spatial segments, using pre-calculated LED coordinates and a buffer for the rotated coordinates
+SpatialPatternMapper sdf_mapping(sdf_pattern, spatial_segments, 2);
+PointBuffer<NUM_LEDS> sdf_points;
+PointBuffer<NUM_LEDS> sdf_rotated_points;
+// Same rotation, transforming each LED coordinate as it is evaluated instead of in one pass (compared with sdf_mapping)
+SpatialPatternMapper sdf_each_mapping(sdf_pattern, spatial_segments, 2);
+// Moved by a transform function, using the same point buffers
+SpatialPatternMapper sdf_plane_mapping(sdf_plane_pattern, spatial_segments, 2);
+// Interlaced, so only a third of the LEDs are evaluated each frame
+SpatialPatternMapper interlaced_sphere_mapping(sphere_pattern, spatial_segments, 2);
+// Pattern wrapped around the centre of the spatial segments 3 times, using a pre-calculated projection table
+ProjectionEntry pinwheel_table[NUM_LEDS];
+ProjectedLinearPatternMapper pinwheel_mapping(pride_pattern, pixel_data, NUM_PIXELS, PROJECT_CYLINDRICAL, spatial_segments, 2,
+                                              pinwheel_table, Point(0, 0, 0), Point(0, 0, 1), 3);
+// Palette indexed pixels, with a brightness array for the moving pulse (resolved to colours as LEDs are written)
+uint8_t pixel_indices[NUM_PIXELS];
+uint8_t pixel_brightness[NUM_PIXELS];
+IndexedLinearPatternMapper indexed_fire_mapping(fire_pattern, pixel_indices, nullptr, NUM_PIXELS, segment_array, 2);
+IndexedLinearPatternMapper indexed_pulse_mapping(pulse_pattern, pixel_indices, pixel_brightness, NUM_PIXELS, segment_array, 2);
+
+LinearPatternMapper first_pulse_mapping(pulse_pattern, pixel_data, SEGMENT_LEN, first_segment_array, 1);
+LinearPatternMapper second_twinkle_mapping(twinkle_pattern, pixel_data2, SEGMENT_LEN, second_segment_array, 1);
+BasePatternMapper* mapper_array[2] = {&first_pulse_mapping, &second_twinkle_mapping};
+MultiplePatternMapper multi_mapping(mapper_array, 2);
+
+// Layers composited over the whole strip: rainbow base, with twinkles added and a pulse blended over it at half opacity
+LinearPatternMapper rainbows_layer_mapping(rainbows_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper twinkle_layer_mapping(twinkle_pattern, pixel_data2, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper pulse_layer_mapping(pulse_pattern, pixel_data3, SEGMENT_LEN, segment_array, 2);
+Layer over_layers[3] = {
+  {&rainbows_layer_mapping, layer_buffers[0], BLEND_OVER, 255},
+  {&twinkle_layer_mapping, layer_buffers[1], BLEND_ADD, 255},
+  {&pulse_layer_mapping, layer_buffers[2], BLEND_ALPHA, 128}
+};
+MultiplePatternMapper over_layered_mapping(over_layers, 3, 0, NUM_LEDS);
+// Layers composited over LEDs 10 to 49 (the segments extend beyond the range): pride base multiplied by a colour fade,
+// with sparkles on top (maximum), all masked by a growing and shrinking bar
+LinearPatternMapper pride_layer_mapping(pride_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper fade_layer_mapping(fade_pattern, pixel_data2, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper sparkle_layer_mapping(sparkle_pattern, pixel_data3, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper grow_layer_mapping(grow_pattern, pixel_data4, NUM_PIXELS, segment_array, 2);
+Layer multiply_layers[4] = {
+  {&pride_layer_mapping, layer_buffers[0], BLEND_OVER, 255},
+  {&fade_layer_mapping, layer_buffers[1], BLEND_MULTIPLY, 255},
+  {&sparkle_layer_mapping, layer_buffers[2], BLEND_MAX, 255},
+  {&grow_layer_mapping, layer_buffers[3], BLEND_MASK, 255}
+};
+MultiplePatternMapper multiply_layered_mapping(multiply_layers, 4, 10, 40);
+// Nested layers over LEDs 10 to 49: rainbows with a colour fade added (composited over the whole strip), with the pulse and
+// twinkles of multi_mapping added on top. Gives the same frames as flat_layered_mapping, which composites all three directly
+LinearPatternMapper nested_rainbows_mapping(rainbows_pattern, pixel_data3, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper nested_fade_mapping(fade_pattern, pixel_data4, NUM_PIXELS, segment_array, 2);
+Layer inner_layers[2] = {
+  {&nested_rainbows_mapping, layer_buffers[0], BLEND_OVER, 255},
+  {&nested_fade_mapping, layer_buffers[1], BLEND_ADD, 255}
+};
+MultiplePatternMapper inner_layered_mapping(inner_layers, 2, 0, NUM_LEDS);
+Layer nested_layers[2] = {
+  {&inner_layered_mapping, layer_buffers[2], BLEND_OVER, 255},
+  {&multi_mapping, layer_buffers[3], BLEND_ADD, 255}
+};
+MultiplePatternMapper nested_layered_mapping(nested_layers, 2, 10, 40);
+Layer flat_layers[3] = {
+  {&nested_rainbows_mapping, layer_buffers[0], BLEND_OVER, 255},
+  {&nested_fade_mapping, layer_buffers[1], BLEND_ADD, 255},
+  {&multi_mapping, layer_buffers[2], BLEND_ADD, 255}
+};
+MultiplePatternMapper flat_layered_mapping(flat_layers, 3, 10, 40);
+
+// Moving pulse repeats every 30 frames (SEGMENT_LEN pixels), so its frames can be cached and played back (the cached mapping
+// must give the same hash as pulse_mapping)
+#define PULSE_LOOP_FRAMES SEGMENT_LEN
+uint8_t pulse_cache_buffer[frame_cache_size(SEGMENT_LEN, PULSE_LOOP_FRAMES)];
+uint8_t pulse_cache565_buffer[frame_cache_size(SEGMENT_LEN, PULSE_LOOP_FRAMES, FRAME_ENCODING_RGB565)];
+FrameCache pulse_cache(pulse_cache_buffer, sizeof(pulse_cache_buffer), PULSE_LOOP_FRAMES);
+FrameCache pulse_cache565(pulse_cache565_buffer, sizeof(pulse_cache565_buffer), PULSE_LOOP_FRAMES, FRAME_ENCODING_RGB565);
+LinearPatternMapper cached_pulse_mapping(pulse_pattern, pixel_data, SEGMENT_LEN, segment_array, 2);
+LinearPatternMapper cached565_pulse_mapping(pulse_pattern, pixel_data, SEGMENT_LEN, segment_array, 2);
+
+// Patterns which render 16 bit pixels, for the high precision pipeline
+LinearPatternMapper fade16_mapping(fade_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+LinearPatternMapper twinkle16_mapping(twinkle_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+
+LinearPatternMapper timed_pulse_mapping(timed_pulse_pattern, pixel_data, SEGMENT_LEN, segment_array, 2);
+LinearPatternMapper timed_rainbows_mapping(timed_rainbows_pattern, pixel_data, NUM_PIXELS, segment_array, 2);
+
+#define NUM_MAPPINGS 27
+MappingRunner mappings[NUM_MAPPINGS] = {
+  MappingRunner(fade_mapping, 20, 10, "RandomColorFade"),
+  MappingRunner(pride_mapping, 20, 10, "Pride"),
+  MappingRunner(rainbows_mapping, 20, 10, "RandomRainbows"),
+  MappingRunner(grow_mapping, 20, 10, "GrowThenShrink"),
+  MappingRunner(pulse_mapping, 20, 10, "MovingPulse"),
+  MappingRunner(disco_mapping, 20, 10, "DiscoStrobe"),
+  MappingRunner(spike_mapping, 20, 10, "SkippingSpike"),
+  MappingRunner(twinkle_mapping, 20, 10, "Twinkle"),
+  MappingRunner(sparkle_mapping, 20, 10, "SparkleFill"),
+  MappingRunner(fire_mapping, 20, 10, "Fire (LinearToSpatial)"),
+  MappingRunner(sphere_mapping, 20, 10, "GrowingSphere (Spatial)"),
+  MappingRunner(multi_mapping, 20, 10, "Pulse + Twinkle (Multiple)"),
+  MappingRunner(rainbow_matrix_mapping, 20, 10, "DiagonalRainbow (Matrix)"),
+  MappingRunner(stream_mapping, 20, 10, "ExternalStream"),
+  MappingRunner(sdf_mapping, 20, 10, "SDF ring and ball (Spatial)"),
+  MappingRunner(pinwheel_mapping, 20, 10, "Pride pinwheel (Projected)"),
+  MappingRunner(indexed_fire_mapping, 20, 10, "Fire (Indexed)"),
+  MappingRunner(indexed_pulse_mapping, 20, 10, "MovingPulse (Indexed)"),
+  MappingRunner(over_layered_mapping, 20, 10, "Rainbows + Twinkle + Pulse (Layered over, add, alpha)"),
+  MappingRunner(multiply_layered_mapping, 20, 10, "Pride, Fade, Sparkle, Grow (Layered multiply, max, mask)"),
+  MappingRunner(interlaced_sphere_mapping, 20, 10, "GrowingSphere (Spatial, interlaced)"),
+  MappingRunner(sdf_plane_mapping, 20, 10, "SDF cut plane (Spatial, transform function)"),
+  MappingRunner(timed_pulse_mapping, 20, 10, "MovingPulse (25 ms steps)"),
+  MappingRunner(timed_rainbows_mapping, 20, 10, "RandomRainbows (30 ms steps)"),
+  MappingRunner(cached_pulse_mapping, 20, 10, "MovingPulse (cached)"),
+  MappingRunner(cached565_pulse_mapping, 20, 10, "MovingPulse (cached RGB565)"),
+  MappingRunner(nested_layered_mapping, 20, 10, "Rainbows + Fade, Pulse + Twinkle (Layered, nested)")
+};
+
+// Hashes of previously recorded output for each mapping (0 if not yet recorded)
+// Update a hash only when a change deliberately alters the output of that mapping
+uint32_t golden_hashes[NUM_MAPPINGS] = {
+  0x56B8BC79,   // RandomColorFade
+  0xC23FCD55,   // Pride
+  0x661CE7E4,   // RandomRainbows
+  0x045318C9,   // GrowThenShrink
+  0x534549F2,   // MovingPulse
+  0xF67533A0,   // DiscoStrobe
+  0x7F03F379,   // SkippingSpike
+  0x116567A5,   // Twinkle
+  0x638CA5E9,   // SparkleFill
+  0x3A632B58,   // Fire (LinearToSpatial)
+  0xC060B3F7,   // GrowingSphere (Spatial)
+  0xBB422475,   // Pulse + Twinkle (Multiple)
+  0xEB97D60D,   // DiagonalRainbow (Matrix)
+  0x83DFBB55,   // ExternalStream
+  0x5A28E95E,   // SDF ring and ball (Spatial)
+  0x0E47A3DA,   // Pride pinwheel (Projected)
+  0x4E8E2EF0,   // Fire (Indexed)
+  0x7C8CD1A4,   // MovingPulse (Indexed)
+  0x6EC3E015,   // Rainbows + Twinkle + Pulse (Layered over, add, alpha)
+  0x76F3E460,   // Pride, Fade, Sparkle, Grow (Layered multiply, max, mask)
+  0x0ECD1157,   // GrowingSphere (Spatial, interlaced)
+  0xC5A5A065,   // SDF cut plane (Spatial, transform function)
+  0x3D5A35FF,   // MovingPulse (25 ms steps)
+  0x375EBB36,   // RandomRainbows (30 ms steps)
+  0x534549F2,   // MovingPulse (cached)
+  0x438DB2E2,   // MovingPulse (cached RGB565)
+  0x774D8F5B    // Rainbows + Fade, Pulse + Twinkle (Layered, nested)
+};
+
+// Mappings recorded through the high precision pipeline (16 bit rendering, then brightness and dithered quantise to 8 bit)
+#define NUM_HP_MAPPINGS 4
+MappingRunner hp_mappings[NUM_HP_MAPPINGS] = {
+  MappingRunner(fade16_mapping, 20, 10, "RandomColorFade (16 bit)"),
+  MappingRunner(twinkle16_mapping, 20, 10, "Twinkle (16 bit)"),
+  MappingRunner(pride_mapping, 20, 10, "Pride (8 bit pattern, high precision)"),
+  MappingRunner(interlaced_sphere_mapping, 20, 10, "GrowingSphere (Spatial, interlaced, high precision)")
+};
+
+uint32_t hp_golden_hashes[NUM_HP_MAPPINGS] = {
+  0x77A40122,   // RandomColorFade (16 bit)
+  0x625DAA6A,   // Twinkle (16 bit)
+  0xC12CBD09,   // Pride (8 bit pattern, high precision)
+  0x79CF18B5    // GrowingSphere (Spatial, interlaced, high precision)
+};
+
+// Slides the cut plane back and forth along the x axis while turning it about the z axis
+AffineTransform slide_plane(uint16_t frame_time) {
+  float angle = frame_time*0.001f;
+  return AffineTransform::translate(Point(100*sinf(2*angle), 0, 0))*Quaternion::fromAxisAngle(Point(0, 0, 1), angle).toTransform();
+}
+
+// Record each mapping, print its hash and compare it with the golden hash. Returns the number of failures
+// If leds16 is provided, mappings are recorded through the high precision pipeline at HP_BRIGHTNESS
+uint8_t checkHashes(MappingRunner* runners, const uint32_t* hashes, uint8_t num_runners, CRGB16* leds16=nullptr) {
+  uint8_t failures = 0;
+  for (uint8_t i=0; i < num_runners; i++) {
+    FrameRecorder recorder(runners[i], leds, NUM_LEDS);
+    if (leds16 != nullptr) {
+      recorder.setHighPrecision(leds16, HP_BRIGHTNESS);
+    }
+    uint32_t hash = recorder.record(NUM_FRAMES);
+    Serial.print(runners[i].name);
+    Serial.print(": 0x");
+    Serial.print(hash, HEX);
+    if (hashes[i] == 0) {
+      Serial.println(" (not recorded)");
+    } else if (hashes[i] == hash) {
+      Serial.println(" PASS");
+    } else {
+      Serial.println(" FAIL");
+      failures++;
+    }
+  }
+  return failures;
+}
+
+// Check that the frames of a mapping are within max_error of the frames of a reference mapping
+// (e.g. an optimised version of the same mapping), with brightness applied to the reference frames. Returns 1 if not
+uint8_t checkError(FrameRecorder& recorder, FrameRecorder& reference, uint8_t max_error, const char* name, uint8_t brightness=255) {
+  reference.record(NUM_COMPARE_FRAMES, nullptr, reference_frames);
+  if (brightness < 255) {
+    for (uint16_t i=0; i < NUM_COMPARE_FRAMES*NUM_LEDS; i++) {
+      reference_frames[i].nscale8(brightness);
+    }
+  }
+  uint8_t error = recorder.maxError(NUM_COMPARE_FRAMES, reference_frames);
+  Serial.print(name);
+  Serial.print(": max error ");
+  Serial.print(error);
+  if (error <= max_error) {
+    Serial.println(" PASS");
+    return 0;
+  }
+  Serial.println(" FAIL");
+  return 1;
+}
+
+void setup() {
+  Serial.begin(115200);
+  sphere_mapping.setPointBuffer(&sphere_points);
+  sdf_mapping.setPointBuffer(&sdf_points, &sdf_rotated_points);
+  sdf_mapping.setRotation(Point(1, 0, 1), 45);
+  sdf_each_mapping.setRotation(Point(1, 0, 1), 45);
+  sdf_plane_mapping.setPointBuffer(&sdf_points, &sdf_rotated_points);
+  sdf_plane_mapping.setTransformFunction(slide_plane);
+  interlaced_sphere_mapping.setInterlace(3, INTERLACE_BLUE_NOISE);
+  fade16_mapping.setHighPrecision(pixel_data16);
+  twinkle16_mapping.setHighPrecision(pixel_data16);
+  cached_pulse_mapping.setFrameCache(&pulse_cache);
+  cached565_pulse_mapping.setFrameCache(&pulse_cache565);
+  // Start from empty caches so the golden hashes include the frames recorded on the first loop
+  pulse_cache.invalidate();
+  pulse_cache565.invalidate();
+  uint8_t failures = checkHashes(mappings, golden_hashes, NUM_MAPPINGS);
+  failures += checkHashes(hp_mappings, hp_golden_hashes, NUM_HP_MAPPINGS, leds16);
+
+  // Transforming each LED as it is evaluated gives the same frames as transforming the point buffer in one pass (up to rounding)
+  MappingRunner sdf_each_runner(sdf_each_mapping, 20, 10);
+  MappingRunner sdf_runner(sdf_mapping, 20, 10);
+  FrameRecorder sdf_each_recorder(sdf_each_runner, leds, NUM_LEDS);
+  FrameRecorder sdf_recorder(sdf_runner, leds, NUM_LEDS);
+  failures += checkError(sdf_each_recorder, sdf_recorder, 1, "Per LED transform vs point buffer transform");
+  // Frames played back from a cache are the same as rendering the pattern, or within the colour error of RGB565
+  MappingRunner pulse_runner(pulse_mapping, 20, 10);
+  MappingRunner cached_pulse_runner(cached_pulse_mapping, 20, 10);
+  MappingRunner cached565_pulse_runner(cached565_pulse_mapping, 20, 10);
+  FrameRecorder pulse_recorder(pulse_runner, leds, NUM_LEDS);
+  FrameRecorder cached_pulse_recorder(cached_pulse_runner, leds, NUM_LEDS);
+  FrameRecorder cached565_pulse_recorder(cached565_pulse_runner, leds, NUM_LEDS);
+  failures += checkError(cached_pulse_recorder, pulse_recorder, 0, "Cached frames vs rendered frames");
+  failures += checkError(cached565_pulse_recorder, pulse_recorder, 7, "RGB565 cached frames vs rendered frames");
+  // Changing a pattern parameter discards the recorded frames, and they are recorded again after reset
+  cached_pulse_runner.setPatternParameter(0, 0);
+  bool invalidated = !pulse_cache.complete();
+  failures += checkError(cached_pulse_recorder, pulse_recorder, 0, "Cached frames after invalidation vs rendered frames");
+  Serial.print("Cache invalidated by parameter change:");
+  if (invalidated && pulse_cache.complete()) {
+    Serial.println(" PASS");
+  } else {
+    Serial.println(" FAIL");
+    failures++;
+  }
+  // Nested layers give the same frames as the equivalent flat layers
+  MappingRunner nested_layered_runner(nested_layered_mapping, 20, 10);
+  MappingRunner flat_layered_runner(flat_layered_mapping, 20, 10);
+  FrameRecorder nested_layered_recorder(nested_layered_runner, leds, NUM_LEDS);
+  FrameRecorder flat_layered_recorder(flat_layered_runner, leds, NUM_LEDS);
+  failures += checkError(nested_layered_recorder, flat_layered_recorder, 0, "Nested layers vs flat layers");
+
+  // The high precision pipeline gives the same frames as rendering in 8 bit and applying brightness, up to rounding and dithering
+  for (uint8_t i=0; i < NUM_HP_MAPPINGS; i++) {
+    FrameRecorder recorder(hp_mappings[i], leds, NUM_LEDS);
+    FrameRecorder reference(hp_mappings[i], leds, NUM_LEDS);
+    recorder.setHighPrecision(leds16, HP_BRIGHTNESS);
+    failures += checkError(recorder, reference, 2, hp_mappings[i].name, HP_BRIGHTNESS);
+  }
+
+  Serial.print("Failures: ");
+  Serial.println(failures);
+}
+
+void loop() {
+}
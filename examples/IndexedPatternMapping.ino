@@ -0,0 +1,44 @@
+// This is an example of using palette indexed pixel arrays on a board with little RAM (e.g. an Arduino Uno with 2KB),
+// for an LED strip of 60 LEDs split into 2 segments of 30 LEDs
+// Patterns render at double resolution for smoother motion, but only use 1 or 2 bytes per pixel instead of 3
+#include <FastLED.h>
+#include <LEDuino.h>
+
+#define LED_DATA_PIN 2
+#define NUM_LEDS 60
+#define SEGMENT_LEN 30
+#define RESOLUTION 60
+CRGB leds[NUM_LEDS];
+
+// Define segments, with the first segment reversed so patterns are mirrored from the middle of the strip
+StripSegment segment_array[2] = {
+  StripSegment(SEGMENT_LEN, SEGMENT_LEN, NUM_LEDS, true),
+  StripSegment(SEGMENT_LEN, SEGMENT_LEN, NUM_LEDS)
+};
+
+// Fire heat is a palette index, so it only needs an index array (60 bytes instead of 180)
+FirePattern<RESOLUTION> fire_pattern;
+uint8_t fire_indices[RESOLUTION];
+IndexedLinearPatternMapper fire_mapping(fire_pattern, fire_indices, nullptr, RESOLUTION, segment_array, 2);
+
+// Moving pulse needs a brightness array as well (120 bytes instead of 180)
+MovingPulsePattern pulse_pattern(12, RainbowColors_picker);
+uint8_t pulse_indices[RESOLUTION];
+uint8_t pulse_brightness[RESOLUTION];
+IndexedLinearPatternMapper pulse_mapping(pulse_pattern, pulse_indices, pulse_brightness, RESOLUTION, segment_array, 2);
+
+MappingRunner mappings[2] = {
+  MappingRunner(fire_mapping, 30),
+  MappingRunner(pulse_mapping)
+};
+
+LEDuinoController controller(leds, NUM_LEDS, mappings, 2, false);
+
+void setup() {
+  FastLED.addLeds<NEOPIXEL, LED_DATA_PIN>(leds, NUM_LEDS).setCorrection(TypicalLEDStrip);
+  controller.initialise();
+}
+
+void loop() {
+  controller.loop();
+}
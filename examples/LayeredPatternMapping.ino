@@ -0,0 +1,56 @@
+// This is an example of compositing two patterns as layers on the same LED strip, using blend modes
+#include <FastLED.h>
+#include <LEDuino.h>
+
+#define LED_DATA_PIN 2
+// Using a WS2812b strip of 60 LEDs
+#define NUM_LEDS 60
+
+// Declare LED array
+CRGB leds[NUM_LEDS];
+
+// Declare Pixel arrays for patterns to use
+CRGB base_pixel_data[NUM_LEDS];
+CRGB overlay_pixel_data[NUM_LEDS];
+
+// Declare buffers for each layer to be rendered into before they are combined (length of LED range covered by layers)
+CRGB base_buffer[NUM_LEDS];
+CRGB overlay_buffer[NUM_LEDS];
+
+// Define segment covering whole strip
+StripSegment segment(0, NUM_LEDS, NUM_LEDS);
+StripSegment segment_array[1] = {segment};
+
+// Define patterns to use
+RandomRainbowsPattern rainbows_pattern;
+TwinklePattern twinkle_pattern;
+
+// Define mapping of each pattern to the strip
+LinearPatternMapper rainbows_mapping(rainbows_pattern, base_pixel_data, NUM_LEDS, segment_array, 1);
+LinearPatternMapper twinkle_mapping(twinkle_pattern, overlay_pixel_data, NUM_LEDS, segment_array, 1);
+
+// Layers from bottom to top: rainbow base, with twinkles added on top
+Layer layers[2] = {
+  {&rainbows_mapping, base_buffer, BLEND_OVER, 255},
+  {&twinkle_mapping, overlay_buffer, BLEND_ADD, 255}
+};
+// Composite layers over whole strip (LEDs 0 to NUM_LEDS-1)
+MultiplePatternMapper layered_mapping(layers, 2, 0, NUM_LEDS);
+
+// Define array of MappingRunners for controller to use
+MappingRunner mappings[1] = {
+  MappingRunner(layered_mapping)
+};
+
+// Define controller
+LEDuinoController controller(leds, NUM_LEDS, mappings, 1, false);
+
+void setup() {
+  // Initialise FastLED
+  FastLED.addLeds<NEOPIXEL, LED_DATA_PIN>(leds, NUM_LEDS).setCorrection(TypicalLEDStrip);
+  controller.initialise();
+}
+
+void loop() {
+  controller.loop();
+}
@@ -0,0 +1,77 @@
+
+// This is an example of projecting linear patterns radially (ripples from the centre) and cylindrically (a pinwheel around the centre),
+// using an LED strip split into 4 segments arranged in a square (as in the SpatialPatternMapping example)
+#include <FastLED.h>
+#include <LEDuino.h>
+
+#define LED_DATA_PIN 2
+#define NUM_LEDS 120
+#define SEGMENT_LEN 30
+#define NUM_SEGMENTS 4
+CRGB leds[NUM_LEDS];
+
+// Pixel array for linear patterns to use (only one mapping runs at a time and pre-warming is not enabled, so it can be shared)
+#define NUM_PIXELS 40
+CRGB pixel_data[NUM_PIXELS];
+
+// Define segments
+StripSegment segment1(0, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment2(SEGMENT_LEN, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment3(SEGMENT_LEN*2, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment4(SEGMENT_LEN*3, SEGMENT_LEN, NUM_LEDS);
+
+// Square with corners at +/-100
+SpatialStripSegment<SEGMENT_LEN> spatial_segment1(segment1, Point(-100, 100, 0), Point(100, 100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment2(segment2, Point(100, 100, 0), Point(100, -100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment3(segment3, Point(100, -100, 0), Point(-100, -100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment4(segment4, Point(-100, -100, 0), Point(-100, 100, 0));
+
+SpatialStripSegment_T* spatial_segments[NUM_SEGMENTS] = {
+  &spatial_segment1,
+  &spatial_segment2,
+  &spatial_segment3,
+  &spatial_segment4
+};
+
+// Define linear patterns to project
+MovingPulsePattern pulse_pattern(8);
+PridePattern pride_pattern;
+
+// Tables for the pre-calculated pattern position of each LED (one per mapping, length equal to number of LEDs in segments)
+ProjectionEntry ripple_table[NUM_LEDS];
+ProjectionEntry pinwheel_table[NUM_LEDS];
+
+// Pulses move outwards from the centre of the square
+ProjectedLinearPatternMapper ripple_mapping(
+  pulse_pattern,
+  pixel_data, NUM_PIXELS,
+  PROJECT_RADIAL,
+  spatial_segments, NUM_SEGMENTS,
+  ripple_table);
+
+// Pattern is wrapped around the centre of the square 3 times
+ProjectedLinearPatternMapper pinwheel_mapping(
+  pride_pattern,
+  pixel_data, NUM_PIXELS,
+  PROJECT_CYLINDRICAL,
+  spatial_segments, NUM_SEGMENTS,
+  pinwheel_table,
+  Point(0, 0, 0),  // Centre of square
+  Point(0, 0, 1),  // Rotate around axis pointing out of square
+  3);
+
+MappingRunner mappings[2] = {
+  MappingRunner(ripple_mapping),
+  MappingRunner(pinwheel_mapping)
+};
+
+LEDuinoController controller(leds, NUM_LEDS, mappings, 2, false);
+
+void setup() {
+  FastLED.addLeds<NEOPIXEL, LED_DATA_PIN>(leds, NUM_LEDS).setCorrection(TypicalLEDStrip);
+  controller.initialise();
+}
+
+void loop() {
+  controller.loop();
+}
@@ -0,0 +1,73 @@
+
+// This is an example of composing a spatial pattern from signed distance field (SDF) shapes,
+// using an LED strip split into 4 segments arranged in a square (as in the SpatialPatternMapping example)
+#include <FastLED.h>
+#include <LEDuino.h>
+
+#define LED_DATA_PIN 2
+#define NUM_LEDS 120
+#define SEGMENT_LEN 30
+#define NUM_SEGMENTS 4
+CRGB leds[NUM_LEDS];
+
+// Define segments
+StripSegment segment1(0, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment2(SEGMENT_LEN, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment3(SEGMENT_LEN*2, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment4(SEGMENT_LEN*3, SEGMENT_LEN, NUM_LEDS);
+
+// Square with corners at +/-100
+SpatialStripSegment<SEGMENT_LEN> spatial_segment1(segment1, Point(-100, 100, 0), Point(100, 100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment2(segment2, Point(100, 100, 0), Point(100, -100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment3(segment3, Point(100, -100, 0), Point(-100, -100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment4(segment4, Point(-100, -100, 0), Point(-100, 100, 0));
+
+SpatialStripSegment_T* spatial_segments[NUM_SEGMENTS] = {
+  &spatial_segment1,
+  &spatial_segment2,
+  &spatial_segment3,
+  &spatial_segment4
+};
+
+// Shapes are defined in pattern coordinates (+/- 256 on each axis)
+// A ring with a ball on one side, smoothly blended together
+SDFTorus ring(Point(0, 0, 0), 200, 24);
+SDFSphere ball(Point(200, 0, 0), 80);
+SDFSmoothUnion ring_and_ball(ring, ball, 60);
+// A tilted plane with a capsule cut out of it
+SDFPlane plane(Point(1, 1, 0), Point(0, 0, 0));
+SDFCapsule capsule(Point(-150, 150, 0), Point(150, -150, 0), 40);
+SDFSubtract cut_plane(plane, capsule);
+
+// Draw the shapes with a palette ramp across a shell around their surfaces
+SDFPattern ring_pattern(ring_and_ball, 80, false, 2, RainbowColors_picker);
+SDFPattern plane_pattern(cut_plane, 64, true, 1, HalloweenColors_picker);
+
+// Rotate the shapes through the square
+SpatialPatternMapper ring_mapping(ring_pattern, spatial_segments, NUM_SEGMENTS);
+SpatialPatternMapper plane_mapping(plane_pattern, spatial_segments, NUM_SEGMENTS);
+
+// Pre-calculated LED coordinates, and buffer for the rotated coordinates of each frame
+PointBuffer<NUM_LEDS> led_points;
+PointBuffer<NUM_LEDS> rotated_points;
+
+MappingRunner mappings[2] = {
+  MappingRunner(ring_mapping),
+  MappingRunner(plane_mapping)
+};
+
+LEDuinoController controller(leds, NUM_LEDS, mappings, 2, false);
+
+void setup() {
+  FastLED.addLeds<NEOPIXEL, LED_DATA_PIN>(leds, NUM_LEDS).setCorrection(TypicalLEDStrip);
+  // Only one mapping runs at a time and pre-warming is not enabled, so they can share the point buffers
+  ring_mapping.setPointBuffer(&led_points, &rotated_points);
+  plane_mapping.setPointBuffer(&led_points, &rotated_points);
+  ring_mapping.setRotation(Point(1, 0, 1), 45);
+  plane_mapping.setRotation(Point(0, 0, 1), -30);
+  controller.initialise();
+}
+
+void loop() {
+  controller.loop();
+}
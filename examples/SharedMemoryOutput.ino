@@ -0,0 +1,65 @@
+// This example is for a host build (Linux or macOS) with no LEDs connected. Every frame is published to a shared memory
+// ring buffer instead of an LED strip, along with the positions of the LEDs, so that a separate visualiser process
+// can display them (using SharedFrameReader to read frames in place, without copying them)
+#include <FastLED.h>
+#include <LEDuino.h>
+#include <SharedMemoryOutput.h>
+
+#define NUM_LEDS 120
+#define SEGMENT_LEN 30
+#define NUM_SEGMENTS 4
+CRGB leds[NUM_LEDS];
+
+#define NUM_PIXELS 40
+CRGB pixel_data[NUM_PIXELS];
+
+// Define segments
+StripSegment segment1(0, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment2(SEGMENT_LEN, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment3(SEGMENT_LEN*2, SEGMENT_LEN, NUM_LEDS);
+StripSegment segment4(SEGMENT_LEN*3, SEGMENT_LEN, NUM_LEDS);
+
+// Square with corners at +/-100
+SpatialStripSegment<SEGMENT_LEN> spatial_segment1(segment1, Point(-100, 100, 0), Point(100, 100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment2(segment2, Point(100, 100, 0), Point(100, -100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment3(segment3, Point(100, -100, 0), Point(-100, -100, 0));
+SpatialStripSegment<SEGMENT_LEN> spatial_segment4(segment4, Point(-100, -100, 0), Point(-100, 100, 0));
+
+SpatialStripSegment_T* spatial_segments[NUM_SEGMENTS] = {
+  &spatial_segment1,
+  &spatial_segment2,
+  &spatial_segment3,
+  &spatial_segment4
+};
+
+FirePattern<NUM_PIXELS> fire_pattern;
+GrowingSpherePattern sphere_pattern;
+
+LinearToSpatialPatternMapper fire_mapping(fire_pattern, pixel_data, NUM_PIXELS, Point(0, 1, 0), spatial_segments, NUM_SEGMENTS);
+SpatialPatternMapper sphere_mapping(sphere_pattern, spatial_segments, NUM_SEGMENTS);
+
+// Use a 1 ms frame delay to render as fast as possible
+MappingRunner mappings[2] = {
+  MappingRunner(fire_mapping, 1),
+  MappingRunner(sphere_mapping, 1)
+};
+
+LEDuinoController controller(leds, NUM_LEDS, mappings, 2, false);
+
+// Shared memory object "/leduino" with 4 frame slots, and FastLED output driver which publishes to it
+SharedFrameBuffer frame_buffer("/leduino", 4);
+SharedMemoryLEDController shared_memory_output(frame_buffer);
+
+void setup() {
+  if (!frame_buffer.open(NUM_LEDS)) {
+    Serial.println("Could not create shared memory");
+  }
+  // LED positions only need to be exported once
+  frame_buffer.exportLayout(spatial_segments, NUM_SEGMENTS);
+  FastLED.addLeds(&shared_memory_output, leds, NUM_LEDS);
+  controller.initialise();
+}
+
+void loop() {
+  controller.loop();
+}
@@ -0,0 +1,192 @@
+#ifndef Audio_h
+#define  Audio_h
+#include <FastLED.h>
+#include <math.h>
+#include "utils.h"
+
+// Can override number of frequency bands by setting before including LEDuino
+#ifndef LEDUINO_AUDIO_BANDS
+	#define LEDUINO_AUDIO_BANDS 8
+#endif
+
+// Results of audio analysis for the current frame
+struct AudioSnapshot {
+	uint8_t bands[LEDUINO_AUDIO_BANDS];	// Energy of logarithmically spaced frequency bands, from lowest to highest frequency (log scale 0-255)
+	uint8_t level;						// Overall energy of audio (log scale 0-255)
+	bool beat;							// Whether a beat (onset in low frequency bands) was detected this frame
+	uint8_t bpm;						// Estimated tempo in beats per minute (0 if no tempo detected yet)
+	uint32_t last_beat_time;			// Time that last beat was detected (in ms)
+};
+
+// Snapshot of latest audio analysis results, shared by all patterns (see BasePattern::audio())
+// All values stay at 0 if no AudioAnalyzer is used
+AudioSnapshot audio_snapshot = {};
+
+// Base interface class for AudioAnalyzer, used for typing without template
+class AudioAnalyzer_T {
+	public:
+		// Run analysis on latest samples and publish results to audio_snapshot. Called by LEDuinoController once per frame
+		virtual void update(uint32_t time) = 0;
+};
+
+// Streaming audio analysis stage. Samples are added to a ring buffer (e.g. from an ADC interrupt or audio library callback),
+// then once per frame the latest t_fft_size samples are windowed and transformed with a fixed-point FFT to get the
+// energy of LEDUINO_AUDIO_BANDS logarithmically spaced frequency bands, detect beats and estimate the tempo.
+// Only integer arithmetic is used after construction, so it is fast enough to run every frame on boards without an FPU.
+// The frequency of each band depends on sample rate. E.g. at 10kHz sample rate with 128 point FFT, bins are 78Hz wide
+template<uint16_t t_fft_size=128>
+class AudioAnalyzer: public AudioAnalyzer_T {
+	public:
+		AudioAnalyzer() {
+			// Pre-calculate Hann window, sine table (covering 3/4 of a cycle so cosine can be read with an offset) and band edges
+			for (uint16_t i=0; i < t_fft_size/2; i++) {
+				this->window[i] = 32767*(0.5 - 0.5*cos((2*PI*i)/(t_fft_size-1)));
+			}
+			for (uint16_t i=0; i < 3*t_fft_size/4; i++) {
+				this->sine[i] = 32767*sin((2*PI*i)/t_fft_size);
+			}
+			// Band edges are spaced logarithmically between bin 1 and the Nyquist bin, with at least 1 bin per band
+			this->band_edges[0] = 1;
+			for (uint8_t b=1; b <= LEDUINO_AUDIO_BANDS; b++) {
+				uint16_t edge = pow(t_fft_size/2, ((float) b)/LEDUINO_AUDIO_BANDS) + 0.5;
+				this->band_edges[b] = edge > this->band_edges[b-1] ? edge : this->band_edges[b-1] + 1;
+			}
+			this->band_edges[LEDUINO_AUDIO_BANDS] = t_fft_size/2;
+		}
+
+		// Add a sample to the ring buffer (can be called from an interrupt)
+		void addSample(int16_t sample) {
+			this->samples[this->write_pos] = sample;
+			this->write_pos = (this->write_pos + 1) % t_fft_size;
+		}
+
+		// Add multiple samples to the ring buffer
+		void addSamples(const int16_t* samples, uint16_t num_samples) {
+			for (uint16_t i=0; i < num_samples; i++) {
+				this->addSample(samples[i]);
+			}
+		}
+
+		void update(uint32_t time) override {
+			this->loadSamples();
+			this->fft();
+			this->calculateBands();
+			this->detectBeat(time);
+		}
+
+	protected:
+		// Copy samples from ring buffer (oldest first) into FFT input with DC offset removed and window applied
+		void loadSamples() {
+			// Take a snapshot of the ring buffer with interrupts disabled, so a sample added from an interrupt can't move
+			// write_pos or overwrite the oldest samples part way through the copy
+			noInterrupts();
+			uint16_t start = this->write_pos;
+			for (uint16_t i=0; i < t_fft_size; i++) {
+				this->real[i] = this->samples[(start + i) % t_fft_size];
+			}
+			interrupts();
+			int32_t sum = 0;
+			for (uint16_t i=0; i < t_fft_size; i++) {
+				sum += this->real[i];
+			}
+			int16_t mean = sum / t_fft_size;
+			for (uint16_t i=0; i < t_fft_size; i++) {
+				int32_t sample = this->real[i] - mean;
+				sample = constrain(sample, -32768, 32767);
+				uint16_t w = i < t_fft_size/2 ? i : t_fft_size-1-i;
+				this->real[i] = (sample * this->window[w]) >> 15;
+				this->imag[i] = 0;
+			}
+		}
+
+		// In-place radix-2 decimation in time FFT in Q15 fixed point. Each stage is scaled by 1/2 to prevent overflow
+		void fft() {
+			// Bit reversal permutation
+			for (uint16_t i=1, j=0; i < t_fft_size; i++) {
+				uint16_t bit = t_fft_size >> 1;
+				for (; j & bit; bit >>= 1) {
+					j ^= bit;
+				}
+				j ^= bit;
+				if (i < j) {
+					int16_t temp = this->real[i];
+					this->real[i] = this->real[j];
+					this->real[j] = temp;
+				}
+			}
+			// Butterflies
+			for (uint16_t half=1; half < t_fft_size; half <<= 1) {
+				uint16_t step = t_fft_size/(2*half);
+				for (uint16_t k=0; k < half; k++) {
+					int32_t wr = this->sine[k*step + t_fft_size/4];	// cos
+					int32_t wi = -this->sine[k*step];					// -sin
+					for (uint16_t i=k; i < t_fft_size; i += 2*half) {
+						uint16_t j = i + half;
+						int32_t tr = (wr*this->real[j] - wi*this->imag[j]) >> 15;
+						int32_t ti = (wr*this->imag[j] + wi*this->real[j]) >> 15;
+						this->real[j] = (this->real[i] - tr) >> 1;
+						this->imag[j] = (this->imag[i] - ti) >> 1;
+						this->real[i] = (this->real[i] + tr) >> 1;
+						this->imag[i] = (this->imag[i] + ti) >> 1;
+					}
+				}
+			}
+		}
+
+		// Sum power of FFT bins in each band, and convert to log scale
+		void calculateBands() {
+			uint32_t total = 0;
+			for (uint8_t b=0; b < LEDUINO_AUDIO_BANDS; b++) {
+				uint32_t energy = 0;
+				for (uint16_t bin=this->band_edges[b]; bin < this->band_edges[b+1]; bin++) {
+					energy += (int32_t) this->real[bin]*this->real[bin] + (int32_t) this->imag[bin]*this->imag[bin];
+				}
+				audio_snapshot.bands[b] = log_scale(energy);
+				// Saturating add
+				total = (total + energy < total) ? 0xFFFFFFFF : total + energy;
+			}
+			audio_snapshot.level = log_scale(total);
+		}
+
+		// Detect beat as a sudden increase in low frequency energy compared to its recent average, and estimate tempo
+		// from the interval between beats
+		void detectBeat(uint32_t time) {
+			uint8_t low = (audio_snapshot.bands[0] + audio_snapshot.bands[1]) / 2;
+			// Average of low band energy (with 4 fractional bits)
+			uint16_t average = this->low_average >> 4;
+			this->low_average += ((int16_t)(low << 4) - (int16_t) this->low_average) >> 3;
+
+			audio_snapshot.beat = false;
+			uint32_t interval = time - audio_snapshot.last_beat_time;
+			if (low > average + 16 && interval > 250) {
+				audio_snapshot.beat = true;
+				// Only use intervals in range of 60-200 BPM for tempo estimate
+				if (interval >= 300 && interval <= 1000) {
+					this->beat_interval = this->beat_interval ? (3*this->beat_interval + interval)/4 : interval;
+					audio_snapshot.bpm = 60000/this->beat_interval;
+				}
+				audio_snapshot.last_beat_time = time;
+			}
+		}
+
+		// Convert energy to log scale 0-255 (8 steps per doubling)
+		static uint8_t log_scale(uint32_t energy) {
+			if (energy == 0) return 0;
+			uint8_t msb = 31;
+			while (!(energy & (1UL << msb))) msb--;
+			// Use next 3 bits below most significant bit as fractional part
+			uint8_t fraction = msb >= 3 ? (energy >> (msb - 3)) & 0x07 : (energy << (3 - msb)) & 0x07;
+			return msb*8 + fraction;
+		}
+
+		volatile int16_t samples[t_fft_size];				// Sample ring buffer
+		volatile uint16_t write_pos=0;						// Position in ring buffer to write next sample
+		int16_t real[t_fft_size], imag[t_fft_size];			// FFT input/output
+		int16_t window[t_fft_size/2];						// First half of symmetric Hann window (Q15)
+		int16_t sine[3*t_fft_size/4];						// Sine table (Q15)
+		uint16_t band_edges[LEDUINO_AUDIO_BANDS+1];			// First FFT bin of each band
+		uint16_t low_average=0;								// Moving average of low band energy (4 fractional bits)
+		uint16_t beat_interval=0;							// Moving average of interval between beats (in ms)
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef ColorConversion_h
+#define  ColorConversion_h
+#include <FastLED.h>
+
+// Fast HSV to RGB conversion kernels, giving identical results to FastLED hsv2rgb_rainbow() (the conversion used by CHSV -> CRGB).
+// The colour of each hue at full saturation and value is looked up from a table (generated with hsv2rgb_rainbow() at startup),
+// then saturation and value are applied inline in the same way as FastLED. This avoids the branching hue calculation
+// and a non-inlined library call for every pixel, and allows work which is constant across a span of pixels to be done once.
+// The table uses 768 bytes of RAM, so by default it is disabled on AVR boards, and for FastLED versions before 3.4 or without
+// FASTLED_SCALE8_FIXED (which calculate saturation differently), in which case the kernels call hsv2rgb_rainbow() for each pixel.
+// Can override by defining LEDUINO_HSV_TABLE as 0 or 1 before including LEDuino
+#ifndef LEDUINO_HSV_TABLE
+	#if defined(__AVR__) || FASTLED_VERSION < 3004000 || (defined(FASTLED_SCALE8_FIXED) && FASTLED_SCALE8_FIXED != 1)
+		#define LEDUINO_HSV_TABLE 0
+	#else
+		#define LEDUINO_HSV_TABLE 1
+	#endif
+#endif
+
+#if LEDUINO_HSV_TABLE
+// Table of FastLED rainbow colour of each hue at full saturation and value
+class RainbowHueTable {
+	public:
+		RainbowHueTable() {
+			for (uint16_t hue=0; hue < 256; hue++) {
+				hsv2rgb_rainbow(CHSV(hue, 255, 255), this->colors[hue]);
+			}
+		}
+
+		const CRGB& operator[](uint8_t hue) const {
+			return this->colors[hue];
+		}
+
+	protected:
+		CRGB colors[256];
+};
+
+RainbowHueTable rainbow_hue_table;
+#endif
+
+// Converts hues to RGB with a constant saturation, with the saturation scaling pre-calculated
+class RainbowConverter {
+	public:
+		RainbowConverter(
+			uint8_t saturation=255		// Saturation of all converted colours
+		): saturation(saturation) {
+			// Saturation scaling as in hsv2rgb_rainbow()
+			uint8_t desat = 255 - saturation;
+			this->desat = scale8_video(desat, desat);
+			this->sat_scale = 255 - this->desat;
+		}
+
+		// Convert hue and value to RGB
+		CRGB convert(uint8_t hue, uint8_t value) const {
+			#if LEDUINO_HSV_TABLE
+				return this->applyValue(this->applySaturation(rainbow_hue_table[hue]), value);
+			#else
+				CRGB rgb;
+				hsv2rgb_rainbow(CHSV(hue, this->saturation, value), rgb);
+				return rgb;
+			#endif
+		}
+
+		// Convert hue and value to RGB, and blend it into existing pixel value (equivalent to nblend(pixel, CHSV(...), amount))
+		void convertBlend(CRGB& pixel, uint8_t hue, uint8_t value, fract8 amount) const {
+			if (amount == 0) return;
+			CRGB overlay = this->convert(hue, value);
+			if (amount == 255) {
+				pixel = overlay;
+				return;
+			}
+			pixel.r = blend8(pixel.r, overlay.r, amount);
+			pixel.g = blend8(pixel.g, overlay.g, amount);
+			pixel.b = blend8(pixel.b, overlay.b, amount);
+		}
+
+	protected:
+		CRGB applySaturation(CRGB rgb) const {
+			if (this->saturation == 255) return rgb;
+			if (this->saturation == 0) return CRGB(255, 255, 255);
+			return CRGB(
+				scale8(rgb.r, this->sat_scale) + this->desat,
+				scale8(rgb.g, this->sat_scale) + this->desat,
+				scale8(rgb.b, this->sat_scale) + this->desat
+			);
+		}
+
+		static CRGB applyValue(CRGB rgb, uint8_t value) {
+			if (value == 255) return rgb;
+			value = scale8_video(value, value);
+			if (value == 0) return CRGB(0, 0, 0);
+			return CRGB(scale8(rgb.r, value), scale8(rgb.g, value), scale8(rgb.b, value));
+		}
+
+		uint8_t saturation;
+		uint8_t desat, sat_scale;		// Brightness floor and scaling for saturation
+};
+
+// Convert a single HSV colour to RGB (same result as hsv2rgb_rainbow())
+inline CRGB hsv2rgb_fast(uint8_t hue, uint8_t saturation, uint8_t value) {
+	return RainbowConverter(saturation).convert(hue, value);
+}
+
+// Convert span of HSV colours to RGB (same result as hsv2rgb_rainbow())
+// Saturation scaling is only re-calculated when saturation changes between pixels
+void hsv2rgb_span(const CHSV* hsv, CRGB* rgb, uint16_t num_pixels) {
+	if (num_pixels == 0) return;
+	RainbowConverter converter(hsv[0].s);
+	uint8_t saturation = hsv[0].s;
+	for (uint16_t i=0; i < num_pixels; i++) {
+		if (hsv[i].s != saturation) {
+			saturation = hsv[i].s;
+			converter = RainbowConverter(saturation);
+		}
+		rgb[i] = converter.convert(hsv[i].h, hsv[i].v);
+	}
+}
+
+// Convert span of HSV colours to RGB and blend them into existing RGB values (same result as nblend() with each converted colour)
+void hsv2rgb_blend_span(const CHSV* hsv, CRGB* rgb, uint16_t num_pixels, fract8 amount) {
+	if (num_pixels == 0) return;
+	RainbowConverter converter(hsv[0].s);
+	uint8_t saturation = hsv[0].s;
+	for (uint16_t i=0; i < num_pixels; i++) {
+		if (hsv[i].s != saturation) {
+			saturation = hsv[i].s;
+			converter = RainbowConverter(saturation);
+		}
+		converter.convertBlend(rgb[i], hsv[i].h, hsv[i].v, amount);
+	}
+}
+
+#endif
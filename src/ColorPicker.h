@@ -1,6 +1,7 @@
 #ifndef colorpicker_h
 #define colorpicker_h
 #include <FastLED.h>
+#include "ColorConversion.h"
 
 
 // Base class for picking a color for use by a pattern
@@ -10,7 +11,12 @@ class ColorPicker {
 	public:
 		// Basic placeholder implementation just gets colour from provided hue and brightness
 		virtual CRGB getColor(uint8_t hue, uint8_t brightness=255, uint8_t saturation=255) const {
-			return CHSV(hue, saturation, brightness);
+			return hsv2rgb_fast(hue, saturation, brightness);
+		};
+
+		// RAM used by picker, including any palette stored in RAM
+		virtual size_t memoryUsage() const {
+			return sizeof(*this);
 		};
 
 };
@@ -23,7 +29,11 @@ class ConstantHuePicker : public ColorPicker {
 		): hue(hue) {}
 
 		virtual CRGB getColor(uint8_t hue, uint8_t brightness=255, uint8_t saturation=255) const {
-			return CHSV(this->hue, saturation, brightness);
+			return hsv2rgb_fast(this->hue, saturation, brightness);
+		};
+
+		size_t memoryUsage() const override {
+			return sizeof(*this);
 		};
 
 	protected:
@@ -31,6 +41,10 @@ class ConstantHuePicker : public ColorPicker {
 };
 
 
+// RAM used by palettes referenced by a PaletteColorPicker (PROGMEM palettes are stored in flash)
+size_t palette_memory_usage(const CRGBPalette16& palette) { return sizeof(palette); }
+size_t palette_memory_usage(const TProgmemRGBPalette16& palette) { return 0; }
+
 // Templated Colour Picker class for using FastLED 16-entry RGB palette types (CRGBPalette16 and TProgmemRGBPalette16)
 template <typename T>
 class PaletteColorPicker: public ColorPicker {
@@ -46,6 +60,10 @@ class PaletteColorPicker: public ColorPicker {
       return ColorFromPalette(this->_palette, hue, brightness, this->blendType);
     }
 
+    size_t memoryUsage() const override {
+      return sizeof(*this) + palette_memory_usage(this->_palette);
+    }
+
   protected:
     const T& _palette;
     TBlendType blendType;
@@ -71,6 +89,10 @@ class GradientPalettePicker: public ColorPicker {
       return ColorFromPalette(this->_palette, hue, brightness, LINEARBLEND);
     }
 
+    size_t memoryUsage() const override {
+      return sizeof(*this);
+    }
+
   protected:
     const CRGBPalette16 _palette;
 };
@@ -0,0 +1,80 @@
+#ifndef CommandQueue_h
+#define  CommandQueue_h
+#include "utils.h"
+
+// Can override size of LEDuinoController command queue by setting before including LEDuino (must be a power of 2, maximum 128)
+#ifndef LEDUINO_COMMAND_QUEUE_SIZE
+	#define LEDUINO_COMMAND_QUEUE_SIZE 16
+#endif
+
+// Memory barrier to ensure queue contents are written before the index which publishes them (and read after)
+// Multi-core processors need a hardware barrier, otherwise only need to prevent compiler reordering
+#if defined(__arm__) || defined(ESP32) || defined(ARDUINO_ARCH_RP2040)
+	#define LEDUINO_MEMORY_BARRIER() __sync_synchronize()
+#else
+	#define LEDUINO_MEMORY_BARRIER() asm volatile("" ::: "memory")
+#endif
+
+// Types of commands which can be sent to the LEDuinoController
+enum CommandType {
+	CMD_SET_MAPPING,				// Switch to mapping runner with ID 'value'
+	CMD_NEXT_MAPPING,				// Switch to next mapping runner (or random one, if controller is randomized)
+	CMD_SET_BRIGHTNESS,				// Set global FastLED brightness to 'value' (0-255)
+	CMD_SET_PATTERN_PARAMETER,		// Set parameter 'param' of the current mapping's pattern(s) to 'value'
+	CMD_SET_AUTO_CHANGE,			// Enable or disable automatically changing mapping when it expires ('value' of 0 or 1)
+	CMD_PAUSE,						// Pause rendering of frames
+	CMD_RESUME						// Resume rendering of frames
+};
+
+// Command to change the controller state
+struct Command {
+	uint8_t type;			// CommandType
+	uint8_t param;			// Parameter ID (for CMD_SET_PATTERN_PARAMETER)
+	int32_t value;			// Value for command
+};
+
+// Bounded lock-free single-producer/single-consumer queue of Commands
+// Allows one producer (e.g. serial handler, button interrupt or other core) to send commands to the render loop without locking.
+// Only the producer modifies 'tail' and only the consumer modifies 'head', and each index is a single byte so is written atomically
+template<uint8_t t_capacity>
+class CommandQueue {
+	public:
+		// Add command to queue (producer only). Returns false if queue is full
+		bool push(const Command& command) {
+			uint8_t tail = this->tail;
+			uint8_t next = (tail + 1) & (t_capacity - 1);
+			if (next == this->head) {
+				return false;
+			}
+			this->commands[tail] = command;
+			LEDUINO_MEMORY_BARRIER();
+			this->tail = next;
+			return true;
+		}
+
+		// Remove next command from queue into 'command' (consumer only). Returns false if queue is empty
+		bool pop(Command& command) {
+			uint8_t head = this->head;
+			if (head == this->tail) {
+				return false;
+			}
+			LEDUINO_MEMORY_BARRIER();
+			command = this->commands[head];
+			LEDUINO_MEMORY_BARRIER();
+			this->head = (head + 1) & (t_capacity - 1);
+			return true;
+		}
+
+		// Whether queue has no commands
+		bool empty() const {
+			return this->head == this->tail;
+		}
+
+	protected:
+		static_assert((t_capacity & (t_capacity - 1)) == 0 && t_capacity <= 128, "Command queue capacity must be a power of 2, maximum 128");
+		Command commands[t_capacity];
+		volatile uint8_t head=0;		// Index of next command to pop
+		volatile uint8_t tail=0;		// Index to push next command to
+};
+
+#endif
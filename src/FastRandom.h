@@ -0,0 +1,119 @@
+#ifndef FastRandom_h
+#define  FastRandom_h
+#include <FastLED.h>
+
+// Fast seedable pseudorandom number generator (xorshift32), for patterns which use lots of random numbers per frame
+// Each pattern has its own generator (see BasePattern::rng), which is seeded from random16() when the pattern is reset,
+// so a MappingRunner with a random seed still renders identically on every run.
+// Bytes are taken 4 at a time from each 32 bit value, bounded integers use multiplication instead of division,
+// and bernoulliMask() makes 32 "one in N" decisions at once
+class FastRandom {
+	public:
+		FastRandom(uint32_t seed=2463534242UL) {
+			this->seed(seed);
+		}
+
+		// Restart sequence from seed
+		void seed(uint32_t seed) {
+			// xorshift state must be non-zero
+			this->state = seed ? seed : 2463534242UL;
+			this->bytes_left = 0;
+		}
+
+		// Next random 32 bit value
+		uint32_t next32() {
+			uint32_t x = this->state;
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			this->state = x;
+			return x;
+		}
+
+		// Next random 16 bit value (upper bits of generator, which are best distributed)
+		uint16_t next16() {
+			return this->next32() >> 16;
+		}
+
+		// Next random byte (each 32 bit value is split into 4 bytes)
+		uint8_t next8() {
+			if (this->bytes_left == 0) {
+				this->byte_buffer = this->next32();
+				this->bytes_left = 4;
+			}
+			uint8_t value = this->byte_buffer;
+			this->byte_buffer >>= 8;
+			this->bytes_left--;
+			return value;
+		}
+
+		// Fill array with random bytes
+		void fill(uint8_t* data, uint16_t length) {
+			uint16_t i = 0;
+			for (; i + 4 <= length; i += 4) {
+				uint32_t value = this->next32();
+				data[i] = value;
+				data[i+1] = value >> 8;
+				data[i+2] = value >> 16;
+				data[i+3] = value >> 24;
+			}
+			for (; i < length; i++) {
+				data[i] = this->next8();
+			}
+		}
+
+		// Unbiased random integer from 0 to range-1 (returns 0 if range is 0)
+		// Uses multiply and shift (Lemire's method), only needing a division in the rare case that a value must be rejected
+		uint16_t below(uint16_t range) {
+			uint32_t m = (uint32_t) this->next16() * range;
+			uint16_t low = m;
+			if (low < range) {
+				uint16_t threshold = (uint16_t) (-range) % range;
+				while (low < threshold) {
+					m = (uint32_t) this->next16() * range;
+					low = m;
+				}
+			}
+			return m >> 16;
+		}
+
+		// Unbiased random integer from min to max-1
+		uint16_t inRange(uint16_t min, uint16_t max) {
+			return min + this->below(max - min);
+		}
+
+		// Return true with probability of probability/256
+		bool chance(uint8_t probability) {
+			return this->next8() < probability;
+		}
+
+		// Mask of 32 independent random bits, each set with probability of probability/65536 (e.g. 65536/N for one in N)
+		// Combines random words with AND/OR from the least significant bit of probability upwards, which takes at most 16
+		// random values for 32 decisions (fewer if probability has trailing zero bits)
+		uint32_t bernoulliMask(uint16_t probability) {
+			if (probability == 0) {
+				return 0;
+			}
+			// Skip trailing zero bits (AND with 0 mask has no effect)
+			uint8_t bit = 0;
+			while (!(probability & (1U << bit))) {
+				bit++;
+			}
+			uint32_t mask = this->next32();
+			for (bit++; bit < 16; bit++) {
+				if (probability & (1U << bit)) {
+					mask |= this->next32();
+				} else {
+					mask &= this->next32();
+				}
+			}
+			return mask;
+		}
+
+	protected:
+		uint32_t state;
+		uint32_t byte_buffer=0;		// Unused bytes of last value (for next8())
+		uint8_t bytes_left=0;		// Number of unused bytes in byte_buffer
+};
+
+#endif
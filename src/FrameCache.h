@@ -0,0 +1,136 @@
+#ifndef FrameCache_h
+#define  FrameCache_h
+#include <FastLED.h>
+
+// Encoding used to store cached frames
+enum FrameEncoding {
+	FRAME_ENCODING_RGB888,		// Full 3 byte CRGB per pixel (lossless, frames are played back with memcpy)
+	FRAME_ENCODING_RGB565		// 2 bytes per pixel (5 bits red, 6 bits green, 5 bits blue), uses 2/3 of the memory with small colour error
+};
+
+// Cache of rendered pattern frames which can be attached to a linear pattern mapper (see BaseLinearPatternMapper::setFrameCache())
+// Records the pattern pixel data for the first 'loop_frames' frames after the mapping is reset, then plays those frames back
+// in a loop instead of running the pattern logic. Trades memory for CPU usage, so is useful for boards with lots of RAM/PSRAM but a slow CPU.
+// Only suitable for patterns which are periodic (repeat every loop_frames frames) and deterministic after reset,
+// (so patterns using random numbers require a random seed to be set on the MappingRunner)
+class FrameCache {
+	public:
+		FrameCache(
+			uint8_t* buffer,								// Buffer to store frames in (can be allocated in PSRAM)
+			size_t buffer_size,								// Size of buffer (in bytes). Nothing is cached if it cannot fit all loop_frames frames
+			uint16_t loop_frames,							// Number of frames after which pattern repeats
+			FrameEncoding encoding=FRAME_ENCODING_RGB888	// Encoding to store frames with
+		):
+			buffer(buffer),
+			buffer_size(buffer_size),
+			loop_frames(loop_frames),
+			encoding(encoding) {}
+
+		// Restart playback/recording from the first frame of the loop
+		// Recorded frames are kept if the loop is complete, otherwise recording is started again (since the pattern 
+		// state would not match the state after the already recorded frames)
+		void rewind() {
+			this->frame_index = 0;
+			if (!this->complete()) {
+				this->recorded_frames = 0;
+			}
+		}
+
+		// Clear all recorded frames (e.g. if pattern parameters have been changed)
+		void invalidate() {
+			this->frame_index = 0;
+			this->recorded_frames = 0;
+		}
+
+		// Load the next frame into pixel_data if it has been recorded. Returns whether frame was available (cache hit)
+		bool load(CRGB* pixel_data, uint16_t num_pixels) {
+			if (this->frame_index >= this->recorded_frames) {
+				this->misses++;
+				return false;
+			}
+			const uint8_t* frame = this->getFrame(this->frame_index, num_pixels);
+			if (this->encoding == FRAME_ENCODING_RGB888) {
+				memcpy(pixel_data, frame, num_pixels*sizeof(CRGB));
+			} else {
+				for (uint16_t i=0; i < num_pixels; i++) {
+					uint16_t value = frame[2*i] | (frame[2*i+1] << 8);
+					uint8_t r = (value >> 8) & 0xF8, g = (value >> 3) & 0xFC, b = value << 3;
+					// Replicate high bits into low bits so that full brightness is preserved
+					pixel_data[i] = CRGB(r | (r >> 5), g | (g >> 6), b | (b >> 5));
+				}
+			}
+			this->hits++;
+			this->nextFrame();
+			return true;
+		}
+
+		// Store pixel_data as the next frame (if it has not been recorded yet and the whole loop fits in buffer)
+		void store(const CRGB* pixel_data, uint16_t num_pixels) {
+			if (this->frame_index == this->recorded_frames && this->loop_frames*this->getFrameSize(num_pixels) <= this->buffer_size) {
+				uint8_t* frame = this->getFrame(this->frame_index, num_pixels);
+				if (this->encoding == FRAME_ENCODING_RGB888) {
+					memcpy(frame, pixel_data, num_pixels*sizeof(CRGB));
+				} else {
+					for (uint16_t i=0; i < num_pixels; i++) {
+						const CRGB& pixel = pixel_data[i];
+						uint16_t value = ((pixel.r & 0xF8) << 8) | ((pixel.g & 0xFC) << 3) | (pixel.b >> 3);
+						frame[2*i] = value & 0xFF;
+						frame[2*i+1] = value >> 8;
+					}
+				}
+				this->recorded_frames++;
+			}
+			this->nextFrame();
+		}
+
+		// Get size of a single frame in the buffer (in bytes)
+		size_t getFrameSize(uint16_t num_pixels) const {
+			return num_pixels * (this->encoding == FRAME_ENCODING_RGB888 ? sizeof(CRGB) : 2);
+		}
+
+		// Whether all frames of the loop have been recorded
+		bool complete() const {
+			return this->recorded_frames == this->loop_frames;
+		}
+
+		// Proportion of frames loaded from cache since statistics were reset (0-255)
+		uint8_t hitRate() const {
+			uint32_t total = this->hits + this->misses;
+			return total ? (255*this->hits)/total : 0;
+		}
+
+		// RAM used by cache, including frame buffer
+		size_t memoryUsage() const {
+			return sizeof(*this) + this->buffer_size;
+		}
+
+		// Reset cache hit statistics
+		void resetStats() {
+			this->hits = this->misses = 0;
+		}
+
+		uint32_t hits=0, misses=0;		// Number of frames loaded from cache, and not available in cache
+
+	protected:
+		// Get pointer to start of frame in buffer
+		uint8_t* getFrame(uint16_t frame_index, uint16_t num_pixels) const {
+			return this->buffer + frame_index*this->getFrameSize(num_pixels);
+		}
+
+		// Move to next frame of loop
+		void nextFrame() {
+			this->frame_index++;
+			if (this->frame_index >= this->loop_frames) {
+				this->frame_index = 0;
+			}
+		}
+
+		uint8_t* buffer;
+		const size_t buffer_size;
+		const uint16_t loop_frames;			// Number of frames in loop
+		const FrameEncoding encoding;
+		uint16_t frame_index=0;				// Frame of loop that will be loaded/stored next
+		uint16_t recorded_frames=0;			// Number of frames recorded from start of loop
+};
+
+#endif
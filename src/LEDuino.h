@@ -10,9 +10,17 @@
 #include "Pattern.h"
 #include "PatternMapping.h"
 #include "MappingRunner.h"
+#include "CommandQueue.h"
+#include "MemoryUsage.h"
+#include "Scheduler.h"
+#include "Pixel16.h"
+#include "PowerMeter.h"
 
 #include "patterns/linear.h"
 #include "patterns/spatial.h"
+#include "patterns/stream.h"
+#include "patterns/matrix.h"
+#include "patterns/sdf.h"
 
 // Controller object which manages a collection of MappingRunners
 // Chooses which mapping to run, and handles running it at the desired framerate
@@ -37,14 +45,144 @@ class LEDuinoController {
 			this->setNewPatternMapping();
 		}
 
+		// Set function used to get the current time for all mapping runners (defaults to millis())
+		void setTimeSource(TimeSource time_source) {
+			this->time_source = time_source;
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				this->mapping_runners[i].setTimeSource(time_source);
+			}
+		}
+
+		// Set AudioAnalyzer to run once per frame before the pattern logic, so patterns can use the results with audio()
+		void setAudioAnalyzer(AudioAnalyzer_T* audio_analyzer) {
+			this->audio_analyzer = audio_analyzer;
+		}
+
+		// Seed random number generators so that pattern order and pattern rendering is deterministic
+		// Each mapping runner is re-seeded with the same value whenever it is reset
+		void setRandomSeed(uint16_t seed) {
+			randomSeed(seed);
+			random16_set_seed(seed);
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				this->mapping_runners[i].setRandomSeed(seed);
+			}
+		}
+
+		// Prepare the next mapping runner before the current one expires, so that switching mapping costs no more than a normal frame.
+		// Within 'lead_time' ms of expiry, calls to loop() when no frame is due reset the next runner and run 'warm_frames' frames
+		// of its pattern logic (one per call), so patterns which build up state (e.g. FirePattern) do not start from black.
+		// Consecutive runners must not share pattern objects, pixel arrays or point buffers, as the next runner is reset and
+		// renders its warm frames while the current one is still running
+		void setPrewarm(
+			uint8_t warm_frames=0,			// Number of frames of pattern logic to run before the runner is shown
+			uint16_t lead_time=1000			// Time before expiry of current runner to start preparing the next (in ms)
+		) {
+			this->prewarm = true;
+			this->warm_frames = warm_frames;
+			this->prewarm_lead_time = lead_time;
+		}
+
+		// Render in 16 bit colour to leds16 (length num_leds), then apply brightness and quantise to the LED array in one pass
+		// with temporal dithering (see DitherQuantiser), so slow fades and low brightness settings do not show visible steps.
+		// Linear mappers keep 16 bit precision from patterns which support it if they have a 16 bit pixel array (see BaseLinearPatternMapper::setHighPrecision()),
+		// other mappers are rendered in 8 bit and converted. Brightness is applied by the controller (see setBrightness()),
+		// so FastLED brightness is set to full. Uses 6 bytes of RAM per LED for leds16
+		void setHighPrecision(
+			CRGB16* leds16,			// 16 bit LED array (length num_leds)
+			bool dither=true		// Whether to dither (otherwise 16 bit values are rounded to the nearest 8 bit value)
+		) {
+			this->quantiser.setBrightness(this->power_meter != nullptr ? this->brightness : FastLED.getBrightness());
+			this->quantiser.setDither(dither);
+			this->leds16 = leds16;
+			for (uint16_t i=0; i < this->num_leds; i++) {
+				this->leds16[i] = CRGB16();
+			}
+			FastLED.setBrightness(255);
+		}
+
+		// Set LED brightness (0-255). In high precision mode, brightness is applied before dithering instead of by FastLED
+		// With a power meter, this is the maximum brightness, which is reduced for frames over the current limits
+		void setBrightness(uint8_t brightness) {
+			this->brightness = brightness;
+			if (this->leds16 != nullptr) {
+				this->quantiser.setBrightness(brightness);
+			} else {
+				FastLED.setBrightness(brightness);
+			}
+		}
+
+		// Estimate the current of each frame with power_meter, and reduce brightness for frames which would exceed its limits (see PowerMeter_T)
+		// Brightness is limited before the frame is output, without FastLED's power limiter making another pass over the LED array.
+		// Linear and spatial mappers add LEDs to the meter as they write them, for other mappers the LED array is measured after rendering
+		void setPowerMeter(PowerMeter_T* power_meter) {
+			this->brightness = this->leds16 != nullptr ? this->quantiser.getBrightness() : FastLED.getBrightness();
+			this->power_meter = power_meter;
+			if (power_meter != nullptr) {
+				power_meter->setNumLEDs(this->num_leds);
+			}
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				this->mapping_runners[i].setPowerMeter(power_meter);
+			}
+		}
+
+		// Register a BackgroundTask to run in the slack time between frames. Returns false if too many tasks are registered
+		bool addBackgroundTask(BackgroundTask task) {
+			return this->scheduler.addTask(task);
+		}
+
+		// Sleep between frames instead of polling the clock (after running any background tasks), to save power and host CPU time
+		// Only used with the default time source, as a simulated clock does not advance while sleeping
+		void setIdleSleep(bool idle_sleep) {
+			this->idle_sleep = idle_sleep;
+		}
+
+		// Start measuring peak stack usage, by painting 'depth' bytes of unused stack (call from setup(), before initialise())
+		// The peak usage during rendering since this was called is included in getMemoryReport()
+		void monitorStack(size_t depth=1024) {
+			this->stack_monitor.paint(depth);
+		}
+
+		// Breakdown of RAM used by all mapping runners, the LED array and the controller
+		// Objects shared between runners are counted once for each runner which uses them
+		MemoryReport getMemoryReport() const {
+			MemoryReport report;
+			report.leds = pixel_buffer_size(this->num_leds);
+			if (this->leds16 != nullptr) {
+				report.leds += pixel_buffer16_size(this->num_leds);
+			}
+			report.mappings = sizeof(*this);
+			if (this->power_meter != nullptr) {
+				report.mappings += this->power_meter->memoryUsage();
+			}
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				this->mapping_runners[i].reportMemory(report);
+			}
+			report.stack = this->stack_monitor.highWater();
+			return report;
+		}
+
+		// Print breakdown of RAM usage (e.g. to Serial)
+		void printMemoryReport(Print& out) const {
+			this->getMemoryReport().print(out);
+		}
+
 		void clear_leds()	{
 			// Reset LED state
 			FastLED.clear();
 			FastLED.show();
 		}
 		
+		// Send command to be applied by the controller at the start of the next loop() (before any frame is rendered)
+		// Safe to call from an interrupt or another core while loop() is running, as long as there is only one sender
+		// Returns false if the command queue is full
+		bool sendCommand(CommandType type, int32_t value=0, uint8_t param=0) {
+			return this->commands.push(Command{(uint8_t) type, param, value});
+		}
+
 		// Run pattern newFrame() if ready, set new pattern if required
 		void loop() {
+			// Apply pending commands between frames
+			this->processCommands();
 			// Check if pattern config needs to be changed
 			if (this->current_runner->expired() && this->auto_change_pattern)	{
 				this->setNewPatternMapping();
@@ -54,8 +192,26 @@ class LEDuinoController {
 				#ifdef LEDUINO_DEBUG		
 					long pre_frame_time = micros();
 				#endif
+				// Update audio analysis results
+				if (this->audio_analyzer != nullptr) {
+					this->audio_analyzer->update(this->time_source());
+				}
+				if (this->power_meter != nullptr) {
+					this->power_meter->beginFrame();
+				}
 				// Run pattern frame logic
-				this->current_runner->newFrame(this->leds);
+				if (this->leds16 != nullptr) {
+					this->current_runner->newFrame16(this->leds16, this->leds, this->num_leds);
+					if (this->power_meter != nullptr) {
+						this->quantiser.setBrightness(this->limitBrightness(this->leds16));
+					}
+					this->quantiser.quantise(this->leds16, this->leds, this->num_leds);
+				} else {
+					this->current_runner->newFrame(this->leds);
+					if (this->power_meter != nullptr) {
+						FastLED.setBrightness(this->limitBrightness(this->leds));
+					}
+				}
 
 				#ifdef LEDUINO_DEBUG
 					long pre_show_time = micros();
@@ -71,11 +227,20 @@ class LEDuinoController {
 					Serial.println(micros()-pre_show_time);
 					Serial.flush();
 				#endif
+			} else if (this->prewarm) {
+				// Use slack time between frames to prepare next mapping
+				this->prewarmNextMapping();
+			}
+			// Run background tasks and/or sleep until the next frame is due
+			if (this->idle_sleep || this->scheduler.hasTasks()) {
+				this->scheduler.run(this->current_runner->timeToNextFrame(), this->idle_sleep && this->time_source == system_millis);
 			}
 		}
 		// Set current active pattern mapper by array index
 		void setPatternMapping(uint8_t runner_id)   {
 			runner_id = limit(runner_id, this->num_mappings-1);
+			bool prepared = this->next_prepared && runner_id == this->next_runner_id;
+			this->next_chosen = this->next_prepared = false;
 			this->current_runner_id = runner_id;
 			this->current_runner = &(this->mapping_runners[runner_id]);
 			#ifdef LEDUINO_DEBUG
@@ -83,8 +248,20 @@ class LEDuinoController {
 				Serial.println(this->current_runner->name);
 				Serial.flush();
 			#endif
-			this->current_runner->reset();
-			this->clear_leds();
+			if (prepared) {
+				// Continue random16() sequence from the end of the prepared runner's warm frames
+				random16_set_seed(this->next_random_state);
+				this->current_runner->start();
+			} else {
+				this->current_runner->reset();
+			}
+			// Clear LED array without showing it, the first frame of the new mapping is shown at the usual frame time
+			FastLED.clear();
+			if (this->leds16 != nullptr) {
+				for (uint16_t i=0; i < this->num_leds; i++) {
+					this->leds16[i] = CRGB16();
+				}
+			}
 		}
 		
 		MappingRunner* current_runner;		// Currently selected mapping runner
@@ -93,26 +270,122 @@ class LEDuinoController {
 
 		CRGB* leds;	
 		const uint16_t num_leds;
+		CRGB16* leds16=nullptr;				// 16 bit LED array in high precision mode (otherwise nullptr)
+		DitherQuantiser quantiser;			// Converts leds16 to leds in high precision mode
+		PowerMeter_T* power_meter=nullptr;	// Optional estimate of current, used to limit brightness
+		uint8_t brightness=255;				// Brightness set with setBrightness() (maximum brightness when there is a power meter)
 		MappingRunner* mapping_runners;
 		const uint8_t num_mappings;
 		const bool randomize;
 		long last_frame_time;
 		uint8_t current_runner_id;
+		TimeSource time_source=system_millis;
+		AudioAnalyzer_T* audio_analyzer=nullptr;
+		CommandQueue<LEDUINO_COMMAND_QUEUE_SIZE> commands;		// Commands waiting to be applied
+		StackMonitor stack_monitor;			// Measures peak stack usage if monitorStack() has been called
+		SlackScheduler scheduler;			// Background tasks run between frames
+		bool idle_sleep=false;				// Whether to sleep between frames
+		bool prewarm=false;					// Whether next mapping is prepared before current mapping expires
+		uint8_t warm_frames=0;				// Number of frames of pattern logic to run when preparing next mapping
+		uint16_t prewarm_lead_time=0;		// Time before expiry to start preparing next mapping (in ms)
+		uint8_t next_runner_id=0;			// ID of next runner, if it has been chosen
+		bool next_chosen=false;				// Whether next runner has been chosen (and preparation started)
+		bool next_prepared=false;			// Whether next runner has been reset (and is ready to start)
+		uint8_t warmed_frames=0;			// Number of frames of pattern logic run for next runner
+		uint16_t next_random_state=0;		// random16() state of next runner between its warm frames
 		
-		// Set ID of new pattern configuration
-		void setNewPatternMapping() {		
-			uint8_t new_pattern_id;
+		// Apply all commands in command queue
+		void processCommands() {
+			Command command;
+			while (this->commands.pop(command)) {
+				switch (command.type) {
+					case CMD_SET_MAPPING:
+						this->setPatternMapping(command.value);
+						break;
+					case CMD_NEXT_MAPPING:
+						this->setNewPatternMapping();
+						break;
+					case CMD_SET_BRIGHTNESS:
+						this->setBrightness(command.value);
+						break;
+					case CMD_SET_PATTERN_PARAMETER:
+						this->current_runner->setPatternParameter(command.param, command.value);
+						break;
+					case CMD_SET_AUTO_CHANGE:
+						this->auto_change_pattern = command.value;
+						break;
+					case CMD_PAUSE:
+						this->current_runner->pause();
+						break;
+					case CMD_RESUME:
+						this->current_runner->resume();
+						break;
+				}
+			}
+		}
+
+		// Brightness for the current frame within the power meter limits (measuring the LED array if the mapper didn't add LEDs to the meter)
+		template<typename PixelT>
+		uint8_t limitBrightness(const PixelT* leds) {
+			if (!this->power_meter->isMeasured()) {
+				this->power_meter->measure(leds, this->num_leds);
+			}
+			return this->power_meter->limitBrightness(this->brightness);
+		}
+
+		// Choose ID of next pattern configuration
+		uint8_t chooseNextMapping() {
 			if (this->randomize)	{
 				// Choose random pattern
-				new_pattern_id = random(0, this->num_mappings);
+				return random(0, this->num_mappings);
 			} else {
 				// Choose next pattern
-				new_pattern_id = (this->current_runner_id + 1)%(this->num_mappings);
+				return (this->current_runner_id + 1)%(this->num_mappings);
 			}
+		}
+
+		// Set ID of new pattern configuration (using the prepared runner if there is one)
+		void setNewPatternMapping() {		
+			uint8_t new_pattern_id = this->next_chosen ? this->next_runner_id : this->chooseNextMapping();
 
 			// TODO: Add transition between patterns?
 			setPatternMapping(new_pattern_id);
 		}
+
+		// Do the next step of preparing the next runner, if the current runner is close to expiry
+		// Each call either resets the next runner or runs one frame of its pattern logic
+		void prewarmNextMapping() {
+			if (!this->auto_change_pattern || this->current_runner->timeRemaining() > this->prewarm_lead_time) {
+				return;
+			}
+			if (!this->next_chosen) {
+				this->next_runner_id = this->chooseNextMapping();
+				this->next_chosen = true;
+				this->warmed_frames = 0;
+				// Can't prepare the runner which is currently running
+				if (this->next_runner_id == this->current_runner_id) {
+					return;
+				}
+			} else if (!this->next_prepared || this->warmed_frames >= this->warm_frames) {
+				return;
+			}
+			// Keep separate random16() sequences for the current and next runners, so that both render the same as without pre-warming
+			uint16_t random_state = random16_get_seed();
+			if (!this->next_prepared) {
+				this->mapping_runners[this->next_runner_id].prepare();
+				this->next_prepared = true;
+				// Seekable patterns don't build up state, so don't need warm frames
+				if (this->mapping_runners[this->next_runner_id].isSeekable()) {
+					this->warmed_frames = this->warm_frames;
+				}
+			} else {
+				random16_set_seed(this->next_random_state);
+				this->mapping_runners[this->next_runner_id].warmFrame();
+				this->warmed_frames++;
+			}
+			this->next_random_state = random16_get_seed();
+			random16_set_seed(random_state);
+		}
 };
 
 #endif
\ No newline at end of file
@@ -26,39 +26,245 @@ class MappingRunner {
 
         // Initialise/Reset pattern state
 		void reset() {		
+			this->prepare();
+			this->start();
+		};
+
+		// Reset pattern state without starting the runner, so it can be pre-warmed with warmFrame() before it is shown
+		void prepare() {
 			#ifdef LEDUINO_DEBUG
 				Serial.print("Initialising pattern mapping configuration: ");
 				Serial.println(this->name);
 				Serial.flush();
 			#endif
-			this->start_time = millis();
-			this->frame_time = 0;
+			// Re-seed random8/16() so that every run of the mapping is identical (Arduino random() is re-seeded by start())
+			if (this->seeded) {
+				random16_set_seed(this->random_seed);
+			}
+			this->warm_time = 0;
 			this->pattern_mapper.reset();
-		};
+		}
+
+		// Run the pattern logic of the next frame without writing to the LEDs (after prepare(), before start())
+		void warmFrame() {
+			this->warm_time += this->frame_delay;
+			this->pattern_mapper.warmFrame(this->warm_time);
+		}
+
+		// Start running from prepared state. Frame time continues on from any pre-warmed frames
+		void start() {
+			// Arduino random() is seeded when the runner starts rather than in prepare(), as its state can't be saved
+			// and restored while the runner is pre-warmed (LEDuinoController restores the random16() state instead)
+			if (this->seeded) {
+				randomSeed(this->random_seed);
+			}
+			this->start_time = this->time_source() - this->warm_time;
+			this->frame_time = this->warm_time;
+			this->paused = false;
+			this->over_budget_frames = this->under_budget_frames = 0;
+		}
 
         // Excute new frame of pattern and map results to LED array
 		void newFrame(CRGB* leds) {
-			this->frame_time = millis() - this->start_time;
-			this->pattern_mapper.newFrame(leds, this->frame_time);
+			this->renderFrame(nullptr, leds, 0);
+		}
+
+		// Excute new frame of pattern and map results to 16 bit LED array (see LEDuinoController::setHighPrecision())
+		void newFrame16(CRGB16* leds16, CRGB* leds, uint16_t num_leds) {
+			this->renderFrame(leds16, leds, num_leds);
 		}
 		
 		// Determine whether pattern has expired (exceeded duration)	
 		bool expired()	{
-			return this->frame_time >= this->duration;
+			return this->frame_time >= this->duration + this->warm_time;
 		};
+
+		// Time until pattern expires (in ms, 0 if expired)
+		uint16_t timeRemaining() const {
+			uint32_t end_time = (uint32_t) this->duration + this->warm_time;
+			return this->frame_time >= end_time ? 0 : end_time - this->frame_time;
+		}
 		
 		// Return whether it is time to start a new frame (frame_delay has elapsed since previous frame time)
 		bool frameReady()	{
-			return (millis() - this->start_time - this->frame_time) >= this->frame_delay;
+			return !this->paused && (this->time_source() - this->start_time - this->frame_time) >= this->frame_delay;
 		};
 
+		// Time until the next frame is ready (in ms, 0 if ready now). Returns frame_delay while paused
+		uint16_t timeToNextFrame() const {
+			if (this->paused) {
+				return this->frame_delay;
+			}
+			uint32_t elapsed = this->time_source() - this->start_time - this->frame_time;
+			return elapsed >= this->frame_delay ? 0 : this->frame_delay - elapsed;
+		}
+
+		// Pause pattern (frame time stops advancing until resumed)
+		void pause() {
+			if (!this->paused) {
+				this->pause_time = this->time_source();
+				this->paused = true;
+			}
+		}
+
+		// Resume paused pattern from the same frame time
+		void resume() {
+			if (this->paused) {
+				this->start_time += this->time_source() - this->pause_time;
+				this->paused = false;
+			}
+		}
+
+		// Set value of a parameter of the mapped pattern(s)
+		void setPatternParameter(uint8_t param_id, int32_t value) {
+			this->pattern_mapper.setPatternParameter(param_id, value);
+		}
+
+		// Set function used to get the current time (defaults to millis())
+		void setTimeSource(TimeSource time_source) {
+			this->time_source = time_source;
+		}
+
+		TimeSource getTimeSource() const {
+			return this->time_source;
+		}
+
+		// Set seed to apply to Arduino random() and FastLED random8/16() whenever the mapping is reset, 
+		// so that patterns using random numbers render identically on every run. random8/16() are seeded before the
+		// pattern is reset, Arduino random() after, so patterns should use random8/16() (or their rng) in reset()
+		void setRandomSeed(uint16_t seed) {
+			this->random_seed = seed;
+			this->seeded = true;
+		}
+
+		// Stop re-seeding random number generators on reset
+		void clearRandomSeed() {
+			this->seeded = false;
+		}
+
+		// Whether a random seed has been set with setRandomSeed()
+		bool hasRandomSeed() const {
+			return this->seeded;
+		}
+
+		uint16_t getRandomSeed() const {
+			return this->random_seed;
+		}
+
+		// Time of the current frame since pattern started (in ms)
+		uint16_t getFrameTime() const {
+			return this->frame_time;
+		}
+
+		// Delay between pattern frames (in ms)
+		uint16_t getFrameDelay() const {
+			return this->frame_delay;
+		}
+
+		// Enable governor which adapts the quality of the mapping (e.g. pattern resolution) to hold the frame rate.
+		// The render time of each frame is measured, and if it exceeds 'target_load' percent of frame_delay for several frames in a row
+		// the quality is stepped down (to a minimum of min_quality). It is only stepped back up after render time has stayed
+		// below half the target for longer, so the quality does not oscillate. Quality is kept when the mapping is reset.
+		// Render time does not include FastLED.show(), so target_load should leave enough of the frame delay for the LED output
+		void setAdaptiveQuality(
+			uint8_t min_quality=0,			// Minimum quality (0-255). Bounds of resolution for each quality are set on the mapper
+			uint8_t target_load=75			// Percentage of frame_delay that rendering should take at most
+		) {
+			this->adaptive_quality = true;
+			this->min_quality = min_quality;
+			this->target_load = target_load;
+			this->quality = 255;
+			this->pattern_mapper.setQuality(this->quality);
+		}
+
+		// Current quality of mapping (0-255)
+		uint8_t getQuality() const {
+			return this->quality;
+		}
+
+		// Whether the mapped patterns only depend on frame time (see BasePattern::isSeekable())
+		bool isSeekable() const {
+			return this->pattern_mapper.isSeekable();
+		}
+
+		// Set PowerMeter for the mapping to add LEDs to as they are written. Returns false if not supported by the mapper
+		bool setPowerMeter(PowerMeter_T* power_meter) {
+			return this->pattern_mapper.setPowerMeter(power_meter);
+		}
+
+		// Add RAM used by runner and its pattern mapping to report
+		void reportMemory(MemoryReport& report) const {
+			report.mappings += sizeof(*this);
+			this->pattern_mapper.reportMemory(report);
+		}
+
+		// Breakdown of RAM used by runner and its pattern mapping
+		MemoryReport getMemoryReport() const {
+			MemoryReport report;
+			this->reportMemory(report);
+			return report;
+		}
+
         const char* name;  // Name or description of pattern
     protected:
+		static const uint8_t QUALITY_STEP = 32;				// Amount quality is changed by each step
+		static const uint8_t QUALITY_DOWN_FRAMES = 3;		// Consecutive overrunning frames before quality is stepped down
+		static const uint8_t QUALITY_UP_FRAMES = 60;		// Consecutive frames well within budget before quality is stepped up
+
+		// Run mapping for the current frame time, to leds16 if it is provided (otherwise leds)
+		void renderFrame(CRGB16* leds16, CRGB* leds, uint16_t num_leds) {
+			this->frame_time = this->time_source() - this->start_time;
+			// Measure render time to adjust quality for following frames
+			uint32_t render_start = this->adaptive_quality ? micros() : 0;
+			if (leds16 != nullptr) {
+				this->pattern_mapper.newFrame16(leds16, leds, num_leds, this->frame_time);
+			} else {
+				this->pattern_mapper.newFrame(leds, this->frame_time);
+			}
+			if (this->adaptive_quality) {
+				this->adjustQuality(micros() - render_start);
+			}
+		}
+
+		// Step quality down or up based on render time of the last frame (in us) compared to the render budget
+		void adjustQuality(uint32_t render_time) {
+			uint32_t budget = (uint32_t) this->frame_delay*10*this->target_load;
+			if (render_time > budget) {
+				this->under_budget_frames = 0;
+				if (++this->over_budget_frames >= QUALITY_DOWN_FRAMES && this->quality > this->min_quality) {
+					this->quality = (this->quality - this->min_quality > QUALITY_STEP) ? this->quality - QUALITY_STEP : this->min_quality;
+					this->pattern_mapper.setQuality(this->quality);
+					this->over_budget_frames = 0;
+				}
+			} else {
+				this->over_budget_frames = 0;
+				if (render_time < budget/2 && ++this->under_budget_frames >= QUALITY_UP_FRAMES) {
+					if (this->quality < 255) {
+						this->quality = (255 - this->quality > QUALITY_STEP) ? this->quality + QUALITY_STEP : 255;
+						this->pattern_mapper.setQuality(this->quality);
+					}
+					this->under_budget_frames = 0;
+				} else if (render_time >= budget/2) {
+					this->under_budget_frames = 0;
+				}
+			}
+		}
+
         BasePatternMapper& pattern_mapper;
     	uint16_t frame_time;			    // Time of the current frame since pattern started (in ms)
+		uint16_t warm_time=0;				// Frame time reached by pre-warmed frames before the runner was started (in ms)
 		uint32_t start_time;			    // Absolute time pattern was initialised (in ms)
         const uint16_t duration;  			// Duration of pattern mapping configuration (in ms)
 		const uint16_t frame_delay;			// Delay between pattern frames (in ms)
+		TimeSource time_source=system_millis;	// Function providing current time (in ms)
+		uint16_t random_seed=0;				// Seed for random number generators, applied on reset if 'seeded'
+		bool seeded=false;
+		bool paused=false;
+		uint32_t pause_time;				// Absolute time pattern was paused (in ms)
+		bool adaptive_quality=false;		// Whether quality governor is enabled
+		uint8_t min_quality=0, target_load=75;
+		uint8_t quality=255;				// Current quality of mapping
+		uint8_t over_budget_frames=0, under_budget_frames=0;	// Consecutive frames over render budget, and well within budget
 };
 
 #endif
\ No newline at end of file
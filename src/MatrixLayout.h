@@ -0,0 +1,79 @@
+#ifndef MATRIXLAYOUT_H
+#define  MATRIXLAYOUT_H
+#include "utils.h"
+
+// Options for wiring of LED matrix panels, can be combined with |
+// Wiring is defined relative to the pattern coordinates (x increases to the right, y increases downwards, origin at top left)
+enum MatrixOptions {
+	MATRIX_PROGRESSIVE=0,			// All rows are wired in the same direction (starting at left)
+	MATRIX_SERPENTINE=1,			// Alternate rows are wired in opposite directions (zig-zag)
+	MATRIX_FLIP_X=2,				// First LED is on the right of the panel
+	MATRIX_FLIP_Y=4,				// First LED is on the bottom of the panel
+	MATRIX_COLUMNS=8,				// LEDs are wired in columns instead of rows
+	MATRIX_TILE_SERPENTINE=16,		// Alternate rows of tiled panels are wired in opposite directions
+	// Rotated panels (rows are wired along the panel height)
+	MATRIX_ROTATE_90=MATRIX_COLUMNS | MATRIX_FLIP_Y,
+	MATRIX_ROTATE_180=MATRIX_FLIP_X | MATRIX_FLIP_Y,
+	MATRIX_ROTATE_270=MATRIX_COLUMNS | MATRIX_FLIP_X,
+};
+
+// Defines the wiring of an LED matrix made up of one or more identical panels arranged in a grid (tiles),
+// and pre-calculates a lookup table from pattern XY coordinates (row-major order) to LED strip index.
+// Panels are assumed to be chained along each row of tiles (starting at top left),
+// each one continuing from the last LED of the previous panel.
+class MatrixLayout {
+	public:
+		MatrixLayout(
+			uint16_t* led_table,			// Array to store lookup table in (length panel_width*panel_height*tiles_x*tiles_y)
+			uint16_t panel_width,			// Width of each panel (number of LEDs)
+			uint16_t panel_height,			// Height of each panel (number of LEDs)
+			uint8_t options=MATRIX_SERPENTINE,	// Wiring options for each panel (combination of MatrixOptions)
+			uint8_t tiles_x=1,				// Number of panels in each row of tiles
+			uint8_t tiles_y=1,				// Number of rows of tiles
+			uint16_t start_offset=0			// Strip index of the first LED of the first panel
+		):
+			led_table(led_table),
+			width(panel_width*tiles_x),
+			height(panel_height*tiles_y) {
+			// Pre-calculate LED strip index of every pixel
+			for (uint16_t y=0; y < this->height; y++) {
+				for (uint16_t x=0; x < this->width; x++) {
+					// Get panel and position within panel
+					uint8_t tile_x = x / panel_width, tile_y = y / panel_height;
+					uint16_t local_x = x % panel_width, local_y = y % panel_height;
+					if ((options & MATRIX_TILE_SERPENTINE) && (tile_y % 2)) {
+						tile_x = tiles_x - 1 - tile_x;
+					}
+					uint16_t tile = tile_y*tiles_x + tile_x;
+					// Convert to position along and across the wired rows of the panel
+					if (options & MATRIX_FLIP_X) local_x = panel_width - 1 - local_x;
+					if (options & MATRIX_FLIP_Y) local_y = panel_height - 1 - local_y;
+					uint16_t row_len = panel_width, row = local_y, row_pos = local_x;
+					if (options & MATRIX_COLUMNS) {
+						row_len = panel_height;
+						row = local_x;
+						row_pos = local_y;
+					}
+					if ((options & MATRIX_SERPENTINE) && (row % 2)) {
+						row_pos = row_len - 1 - row_pos;
+					}
+					this->led_table[y*this->width + x] = start_offset + tile*panel_width*panel_height + row*row_len + row_pos;
+				}
+			}
+		}
+
+		// Get LED strip index of pixel at XY coordinates
+		uint16_t getLEDId(uint16_t x, uint16_t y) const {
+			return this->led_table[limit(y, this->height-1)*this->width + limit(x, this->width-1)];
+		}
+
+		// Number of pixels in matrix
+		uint16_t size() const {
+			return this->width*this->height;
+		}
+
+		uint16_t* const led_table;				// LED strip index of each pixel (row-major)
+		const uint16_t width, height;			// Dimensions of whole matrix
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef MemoryUsage_h
+#define  MemoryUsage_h
+#include <FastLED.h>
+#include "utils.h"
+#include "FrameCache.h"
+
+// Compile-time sizes (in bytes) of buffers which are allocated by the user, for sizing LED counts to the available RAM
+// Sizes of objects can be found with sizeof(), e.g. sizeof(SpatialStripSegment<60>) or sizeof(FirePattern<120>)
+constexpr size_t pixel_buffer_size(uint16_t num_pixels) { return num_pixels*sizeof(CRGB); }
+constexpr size_t matrix_table_size(uint16_t width, uint16_t height) { return width*height*sizeof(uint16_t); }
+constexpr size_t frame_cache_size(uint16_t num_pixels, uint16_t loop_frames, FrameEncoding encoding=FRAME_ENCODING_RGB888) {
+	return (size_t) loop_frames*num_pixels*(encoding == FRAME_ENCODING_RGB888 ? sizeof(CRGB) : 2);
+}
+
+// Breakdown of RAM used by a mapping configuration (in bytes)
+// Objects shared between mappings (e.g. patterns, pickers or segments) are counted once for every mapping which uses them
+struct MemoryReport {
+	size_t leds=0;				// LED array
+	size_t segments=0;			// StripSegments, and SpatialStripSegments including LED positions
+	size_t pixel_buffers=0;		// Pattern pixel arrays, layer buffers, lookup tables and frame caches
+	size_t patterns=0;			// Pattern objects (pattern state)
+	size_t palettes=0;			// Colour pickers, including palettes stored in RAM
+	size_t mappings=0;			// Pattern mappers, MappingRunners and controller
+	size_t stack=0;				// Peak stack usage measured by StackMonitor (0 if not measured)
+
+	// Total RAM used (not including stack)
+	size_t total() const {
+		return this->leds + this->segments + this->pixel_buffers + this->patterns + this->palettes + this->mappings;
+	}
+
+	// Add sizes from another report
+	MemoryReport& operator+=(const MemoryReport& other) {
+		this->leds += other.leds;
+		this->segments += other.segments;
+		this->pixel_buffers += other.pixel_buffers;
+		this->patterns += other.patterns;
+		this->palettes += other.palettes;
+		this->mappings += other.mappings;
+		this->stack = max(this->stack, other.stack);
+		return *this;
+	}
+
+	// Print breakdown (e.g. to Serial)
+	void print(Print& out) const {
+		out.print("LEDs: "); out.println((unsigned long) this->leds);
+		out.print("Segments: "); out.println((unsigned long) this->segments);
+		out.print("Pixel buffers: "); out.println((unsigned long) this->pixel_buffers);
+		out.print("Patterns: "); out.println((unsigned long) this->patterns);
+		out.print("Palettes: "); out.println((unsigned long) this->palettes);
+		out.print("Mappings: "); out.println((unsigned long) this->mappings);
+		out.print("Total: "); out.println((unsigned long) this->total());
+		out.print("Peak stack: "); out.println((unsigned long) this->stack);
+		out.print("Free memory: "); out.println(freeMemory());
+	}
+};
+
+// Measures peak stack usage by 'painting' unused stack below the caller with a known value, then checking how much
+// of it has since been overwritten. Paint from a shallow point (e.g. setup()) so that rendering happens deeper in the stack
+class StackMonitor {
+	public:
+		static const uint8_t PAINT_VALUE = 0xA5;
+
+		// Paint up to 'depth' bytes of stack below the caller (limited to the free memory between heap and stack)
+		void __attribute__((noinline)) paint(size_t depth) {
+			volatile uint8_t marker = 0;
+			// Leave a margin below this function's own stack frame
+			this->start = (volatile uint8_t*) &marker - 64;
+			int free_memory = freeMemory() - 128;
+			if (free_memory > 0 && depth > (size_t) free_memory) {
+				depth = free_memory;
+			}
+			this->depth = depth;
+			for (size_t i=0; i < depth; i++) {
+				this->start[-(ptrdiff_t) i] = PAINT_VALUE;
+			}
+		}
+
+		// Peak stack usage below the painted start position since painting (in bytes)
+		size_t highWater() const {
+			// Find deepest byte which has been overwritten
+			size_t untouched = 0;
+			while (untouched < this->depth && this->start[-(ptrdiff_t) (this->depth - 1 - untouched)] == PAINT_VALUE) {
+				untouched++;
+			}
+			return this->depth - untouched;
+		}
+
+		// Whether the whole painted area has been used (so peak usage may be higher than measured)
+		bool overflowed() const {
+			return this->depth > 0 && this->highWater() == this->depth;
+		}
+
+	protected:
+		volatile uint8_t* start=nullptr;	// Highest painted address
+		size_t depth=0;						// Number of bytes painted
+};
+
+#endif
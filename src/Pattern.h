@@ -4,10 +4,52 @@
 #include "Point.h"
 #include "utils.h"
 #include "ColorPicker.h"
+#include "Audio.h"
+#include "FastRandom.h"
+#include "MemoryUsage.h"
+#include "Pixel16.h"
+
+// Coverage of the pixels of a pattern frame, used to skip work when compositing layers (see MultiplePatternMapper)
+enum LayerState {
+	LAYER_PARTIAL,		// Unknown, or some pixels are black
+	LAYER_EMPTY,		// All pixels are black
+	LAYER_OPAQUE		// No pixels are black
+};
+
+// Counts the animation steps of patterns which advance their state by a fixed amount each step
+// By default there is one step per frame, so the speed of the pattern depends on the achieved frame rate. If a step time is set,
+// the number of steps is calculated from frame_time instead, so the pattern state only depends on frame_time
+// (and the random seed set on reset) and the pattern is seekable (see BasePattern::isSeekable())
+class StepClock {
+	public:
+		StepClock(
+			uint16_t step_time=0		// Time of each step (in ms), or 0 for one step per frame
+		): step_time(step_time) {}
+
+		void reset() {
+			this->frames = 0;
+		}
+
+		// Number of steps at frame_time since reset (must be called once per frame)
+		uint32_t update(uint32_t frame_time) {
+			return this->step_time ? frame_time/this->step_time : ++this->frames;
+		}
+
+		// Whether steps are calculated from frame time
+		bool seekable() const {
+			return this->step_time != 0;
+		}
+
+	protected:
+		const uint16_t step_time;
+		uint32_t frames=0;			// Number of frames since reset
+};
 
 // Abstract Base class for patterns. Subclasses override frameAction() to implement pattern logic
 // Pattern logic can be defined in terms of frames (so that speed will be determined by framerate), 
 // or by absolute time (using frame_time or FastLED beatX functions)
+// All pattern state must be stored in member variables (not function-level static variables) and initialised in reset(),
+// so that multiple instances of a pattern are independent and a reset pattern always renders the same way
 class BasePattern	{
 	public:
 		// Constructor
@@ -18,7 +60,31 @@ class BasePattern	{
 			
 			
 		// Initialise/Reset pattern state
-		virtual void reset() {};
+		// Subclasses overriding this must call the base class reset(), which seeds the pattern random number generator
+		virtual void reset() {
+			this->rng.seed(((uint32_t) random16() << 16) | random16());
+		};
+
+		// Set value of a pattern parameter (e.g. from a remote control). Parameter IDs are defined by each pattern
+		// Patterns without adjustable parameters ignore this
+		virtual void setParameter(uint8_t param_id, int32_t value) {};
+
+		// Whether the pattern state is calculated from frame_time (and the seed set on reset) instead of being advanced every frame
+		// Frames of seekable patterns can be skipped, rendered out of order or rendered ahead of time without changing the output,
+		// and their speed doesn't depend on the frame rate
+		virtual bool isSeekable() const { return false; };
+
+		// Coverage of pixels in the last frame. Patterns can override this if it is known without checking every pixel
+		virtual LayerState getLayerState() const { return LAYER_PARTIAL; };
+
+		// RAM used by pattern (derive patterns from SizedPattern to return their own size, and override to add any tables they use)
+		virtual size_t memoryUsage() const { return sizeof(*this); };
+
+		// Add memory used by pattern and its colour picker to report
+		void reportMemory(MemoryReport& report) const {
+			report.patterns += this->memoryUsage();
+			report.palettes += this->color_picker.memoryUsage();
+		}
 
 	protected:
 	
@@ -26,8 +92,14 @@ class BasePattern	{
 		CRGB getColor(uint8_t hue, uint8_t brightness=255) const {
 			return this->color_picker.getColor(hue, brightness);
 		}
+
+		// Get latest audio analysis results (read-only, updated by the LEDuinoController once per frame if it has an AudioAnalyzer)
+		const AudioSnapshot& audio() const {
+			return audio_snapshot;
+		}
 		
 		const ColorPicker& color_picker;
+		FastRandom rng;			// Random number generator for pattern (seeded from random16() on reset)
 };
 
 // Base class for patterns defined on a simple linear axis 
@@ -43,6 +115,21 @@ class LinearPattern: public BasePattern	{
 		// Overidde frameAction() for updating pattern state with each frame, and setting the pixel values in pixel_data	
 		virtual void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time) = 0;
 
+		// Optional 16 bit version of frameAction(), used when the mapper has a 16 bit pixel array (see BaseLinearPatternMapper::setHighPrecision())
+		// Patterns with slow fades or dim colours can override this to keep their precision. Returns false if not supported,
+		// in which case frameAction() is used instead
+		virtual bool frameAction16(CRGB16* pixel_data, uint16_t num_pixels, uint32_t frame_time) { return false; };
+
+		// Optional palette indexed version of frameAction(), used by IndexedLinearPatternMapper. Sets a colour picker index for each pixel,
+		// and a brightness if brightness is not nullptr, which the mapper resolves to a colour with indexedColor() when writing LEDs.
+		// Returns false if not supported (or if brightness is nullptr and the pattern needs it, e.g. to draw black pixels)
+		virtual bool frameActionIndexed(uint8_t* indices, uint8_t* brightness, uint16_t num_pixels, uint32_t frame_time) { return false; };
+
+		// Colour of a pixel set by frameActionIndexed()
+		virtual CRGB indexedColor(uint8_t index, uint8_t brightness) const {
+			return this->getColor(index, brightness);
+		}
+
 };
 
 // Pattern defined in 3D space. Converts a 3D coordinate of a pixel into a colour value
@@ -65,4 +152,35 @@ class SpatialPattern : public BasePattern {
 
 		const uint16_t resolution;
 };
-#endif
\ No newline at end of file
+
+// Pattern defined on a 2D grid of pixels (e.g. an LED matrix), which populates a row-major pixel array (width*height)
+// Subclasses can either override frameAction() to set the whole pixel array, or override rowAction() to fill one row (scanline) at a time
+class MatrixPattern : public BasePattern {
+	public:
+		MatrixPattern(	
+			const ColorPicker& color_picker=Basic_picker	// Colour picker/palette to use for pattern 
+		): 
+		BasePattern(color_picker) {}
+
+		// Update pattern state with each frame, and set the pixel values in pixel_data (row y starts at pixel_data[y*width])
+		// Default implementation calls rowAction() for each row
+		virtual void frameAction(CRGB* pixel_data, uint16_t width, uint16_t height, uint32_t frame_time) {
+			for (uint16_t y=0; y < height; y++) {
+				this->rowAction(&pixel_data[y*width], width, y, frame_time);
+			}
+		}
+
+		// Set the pixel values of a single row of the pattern
+		virtual void rowAction(CRGB* row_data, uint16_t width, uint16_t y, uint32_t frame_time) {}
+};
+
+// Implements memoryUsage() for pattern class T derived from Base (LinearPattern, SpatialPattern or MatrixPattern),
+// e.g. class MyPattern : public SizedPattern<MyPattern, LinearPattern>
+template<class T, class Base>
+class SizedPattern : public Base {
+	public:
+		using Base::Base;
+
+		size_t memoryUsage() const override { return sizeof(T); }
+};
+#endif
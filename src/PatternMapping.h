@@ -5,6 +5,10 @@
 #include "StripSegment.h"
 #include "Pattern.h"
 #include "Point.h"
+#include "FrameCache.h"
+#include "MatrixLayout.h"
+#include "PointBuffer.h"
+#include "PowerMeter.h"
 
 
 // Base interface class for defining a mapping of a pattern to some kind of configuration of LEDS
@@ -17,6 +21,76 @@ class BasePatternMapper {
 		// Excute new frame of pattern and map results to LED array
 		virtual void newFrame(CRGB* leds, uint16_t frame_time) const = 0;
 
+		// Excute new frame of pattern and map results to a 16 bit LED array (used by LEDuinoController in high precision mode)
+		// Default implementation maps to the 8 bit LED array, and converts the whole array to 16 bit. The LED array holds the
+		// quantised output of the last frame (with brightness applied), so it is first restored from leds16, so that LEDs the
+		// mapper doesn't write this frame (e.g. when interlaced or layered) keep the mapper's own values
+		virtual void newFrame16(CRGB16* leds16, CRGB* leds, uint16_t num_leds, uint16_t frame_time) const {
+			narrow_pixels(leds16, leds, num_leds);
+			this->newFrame(leds, frame_time);
+			widen_pixels(leds, leds16, num_leds);
+		};
+
+		// Set value of a parameter of the mapped pattern(s)
+		virtual void setPatternParameter(uint8_t param_id, int32_t value) const {};
+
+		// Set rendering quality (0-255, where 255 is full quality). Used by MappingRunner to reduce render time when frames overrun
+		// Mappers may reduce pattern resolution and/or mapping accuracy within their configured bounds
+		virtual void setQuality(uint8_t quality) const {};
+
+		// Coverage of the LEDs written by the last frame (see LayerState)
+		virtual LayerState getLayerState() const { return LAYER_PARTIAL; };
+
+		// Whether the state of the mapped pattern(s) only depends on frame_time (see BasePattern::isSeekable())
+		virtual bool isSeekable() const { return false; };
+
+		// Run pattern logic for a frame without writing to the LEDs (used to pre-warm patterns before they are shown)
+		virtual void warmFrame(uint16_t frame_time) const {};
+
+		// Add RAM used by mapping (and the patterns, segments and buffers it uses) to report
+		virtual void reportMemory(MemoryReport& report) const {
+			report.mappings += sizeof(*this);
+		};
+
+		// Set PowerMeter to add LEDs to as they are written, so the current of each frame is estimated without another pass over
+		// the LED array. Only for mappers which write to the LED array directly (see LEDuinoController::setPowerMeter())
+		// Returns false if not supported by the mapper
+		virtual bool setPowerMeter(PowerMeter_T* power_meter) { return false; };
+
+		// Restrict LED writes to num_leds LEDs from led_offset, and address them relative to led_offset, so the mapping can render
+		// into a buffer covering part of the LED array (used by MultiplePatternMapper for layers). LEDs outside the range are not written
+		virtual void setLEDWindow(uint16_t led_offset, uint16_t num_leds) {
+			this->window_offset = led_offset;
+			this->window_leds = num_leds;
+		}
+
+		// Write to the whole LED array (default). Goes through setLEDWindow(), so mappers which forward the window also forward this
+		void clearLEDWindow() {
+			this->setLEDWindow(0, 0xFFFF);
+		}
+
+	protected:
+		// Write value to LED led_id of the LED array, if it is within the LED window
+		template<typename PixelT>
+		void setLED(PixelT* leds, uint16_t led_id, const PixelT& value) const {
+			uint16_t index = led_id - this->window_offset;
+			if (index < this->window_leds) {
+				leds[index] = value;
+			}
+		}
+
+		// Add value of LED led_id of segment segment_id to the power meter (if there is one) as it is written, if it is within the LED window
+		template<typename PixelT>
+		void meterLED(uint8_t segment_id, uint16_t led_id, const PixelT& value) const {
+			if (this->power_meter != nullptr && (uint16_t) (led_id - this->window_offset) < this->window_leds) {
+				this->power_meter->add(segment_id, led_id, value);
+			}
+		}
+
+		PowerMeter_T* power_meter=nullptr;		// Optional PowerMeter to add LEDs to
+		uint16_t window_offset=0;				// Index of first LED written (see setLEDWindow())
+		uint16_t window_leds=0xFFFF;			// Number of LEDs which can be written
+
 };
 
 // Base class for Mappings that use a LinearPattern
@@ -29,18 +103,133 @@ class BaseLinearPatternMapper: public BasePatternMapper {
 		): 
 		pattern(pattern),
 		pixel_data(pixel_data),
-		num_pixels(num_pixels) {}
+		num_pixels(num_pixels),
+		max_pixels(num_pixels),
+		min_pixels(num_pixels) {}
 
 		// Initialise/Reset pattern state
 		void reset() const override {
-			fill_solid(this->pixel_data, this->num_pixels, CRGB::Black);
+			if (this->pixel_data != nullptr) {
+				fill_solid(this->pixel_data, this->max_pixels, CRGB::Black);
+			}
+			if (this->pixel_data16 != nullptr) {
+				for (uint16_t i=0; i < this->max_pixels; i++) {
+					this->pixel_data16[i] = CRGB16();
+				}
+			}
 			this->pattern.reset();
+			if (this->frame_cache != nullptr) {
+				this->frame_cache->rewind();
+			}
+		}
+
+		// Set value of a parameter of the pattern
+		void setPatternParameter(uint8_t param_id, int32_t value) const override {
+			this->pattern.setParameter(param_id, value);
+			// Recorded frames are no longer valid
+			if (this->frame_cache != nullptr) {
+				this->frame_cache->invalidate();
+			}
+		}
+
+		// Attach a FrameCache to record the pattern frames and play them back instead of running the pattern logic
+		// Only suitable for periodic patterns which are deterministic after reset (see FrameCache)
+		void setFrameCache(FrameCache* frame_cache) {
+			this->frame_cache = frame_cache;
+		}
+
+		// Set 16 bit pixel array (length equal to num_pixels) for patterns which support frameAction16() to render to, so that mappers
+		// which support 16 bit output keep the full precision of the pattern (see LEDuinoController::setHighPrecision())
+		void setHighPrecision(CRGB16* pixel_data16) {
+			this->pixel_data16 = pixel_data16;
+		}
+
+		// Set minimum pattern resolution which can be used when quality is reduced (defaults to num_pixels, so resolution is fixed)
+		// For LinearPatternMapper, should not be less than the length of the longest strip segment
+		void setMinResolution(uint16_t min_pixels) {
+			this->min_pixels = limit(min_pixels, this->max_pixels);
+		}
+
+		// Scale pattern resolution between the minimum resolution and num_pixels
+		void setQuality(uint8_t quality) const override {
+			uint16_t resolution = this->min_pixels + ((uint32_t) (this->max_pixels - this->min_pixels)*quality)/255;
+			resolution = this->snapResolution(resolution);
+			if (resolution != this->num_pixels) {
+				this->num_pixels = resolution;
+				// Recorded frames are no longer valid
+				if (this->frame_cache != nullptr) {
+					this->frame_cache->invalidate();
+				}
+			}
+		}
+
+		// Current pattern resolution
+		uint16_t getResolution() const {
+			return this->num_pixels;
+		}
+
+		LayerState getLayerState() const override {
+			// Pattern state is not known when the frame was loaded from cache
+			return this->frame_cache == nullptr ? this->pattern.getLayerState() : LAYER_PARTIAL;
+		}
+
+		bool isSeekable() const override {
+			return this->pattern.isSeekable();
+		}
+
+		void warmFrame(uint16_t frame_time) const override {
+			this->renderPattern(frame_time);
 		}
 		
 	protected:
+		// Adjust a reduced pattern resolution to one which the mapper can use efficiently (must be between min_pixels and max_pixels)
+		virtual uint16_t snapResolution(uint16_t resolution) const {
+			return resolution;
+		}
+
+		// Add RAM used by pattern, pixel array and frame cache to report
+		void reportPatternMemory(MemoryReport& report) const {
+			this->pattern.reportMemory(report);
+			if (this->pixel_data != nullptr) {
+				report.pixel_buffers += pixel_buffer_size(this->max_pixels);
+			}
+			if (this->pixel_data16 != nullptr) {
+				report.pixel_buffers += pixel_buffer16_size(this->max_pixels);
+			}
+			if (this->frame_cache != nullptr) {
+				report.pixel_buffers += this->frame_cache->memoryUsage();
+			}
+		}
+
+
+		// Run pattern logic to populate pixel_data (or load frame from cache if available)
+		void renderPattern(uint16_t frame_time) const {
+			if (this->frame_cache != nullptr && this->frame_cache->load(this->pixel_data, this->num_pixels)) {
+				return;
+			}
+			this->pattern.frameAction(this->pixel_data, this->num_pixels, frame_time);
+			if (this->frame_cache != nullptr) {
+				this->frame_cache->store(this->pixel_data, this->num_pixels);
+			}
+		}
+
+		// Run pattern logic to populate pixel_data16. Patterns without 16 bit support (or frames from the cache) are rendered
+		// to pixel_data and converted
+		void renderPattern16(uint16_t frame_time) const {
+			if (this->frame_cache == nullptr && this->pattern.frameAction16(this->pixel_data16, this->num_pixels, frame_time)) {
+				return;
+			}
+			this->renderPattern(frame_time);
+			widen_pixels(this->pixel_data, this->pixel_data16, this->num_pixels);
+		}
+
 		LinearPattern& pattern;
-		CRGB* pixel_data;
-		const uint16_t num_pixels;
+		CRGB* pixel_data;						// Pixel array (nullptr for IndexedLinearPatternMapper)
+		CRGB16* pixel_data16=nullptr;			// Optional 16 bit pixel array
+		mutable uint16_t num_pixels;			// Current pattern resolution (reduced from max_pixels when quality is reduced)
+		const uint16_t max_pixels;				// Full pattern resolution (length of pixel_data)
+		uint16_t min_pixels;					// Minimum pattern resolution when quality is reduced
+		FrameCache* frame_cache=nullptr;		// Optional cache of pattern frames
 		
 };
 
@@ -59,6 +248,17 @@ class LinearPatternMapper: public BaseLinearPatternMapper {
 		BaseLinearPatternMapper(pattern, pixel_data, num_pixels), 
 		strip_segments(strip_segments), 
 		num_segments(num_segments) {}
+
+		void reportMemory(MemoryReport& report) const override {
+			report.mappings += sizeof(*this);
+			report.segments += this->num_segments*sizeof(StripSegment);
+			this->reportPatternMemory(report);
+		}
+
+		bool setPowerMeter(PowerMeter_T* power_meter) override {
+			this->power_meter = power_meter;
+			return true;
+		}
 		
 		// Excute new frame of pattern and map results to LED array
 		// This implementation involves calling pattern.getPixelValue() multiple times for the same pattern pixel index which is inefficient
@@ -67,58 +267,103 @@ class LinearPatternMapper: public BaseLinearPatternMapper {
 		// and LinearStatePatterns have their own pixel array anyway and can be used if required
 		void newFrame(CRGB* leds, uint16_t frame_time)	const override {
 			// Run pattern logic
-			this->pattern.frameAction(this->pixel_data, this->num_pixels, frame_time);			
+			this->renderPattern(frame_time);
+			this->mapSegments<CRGB, uint16_t>(leds, this->pixel_data);
+		};
+
+		// Excute new frame of pattern and map results to 16 bit LED array, averaging downsampled pixels with 32 bit sums
+		void newFrame16(CRGB16* leds16, CRGB* leds, uint16_t num_leds, uint16_t frame_time) const override {
+			if (this->pixel_data16 == nullptr) {
+				BaseLinearPatternMapper::newFrame16(leds16, leds, num_leds, frame_time);
+				return;
+			}
+			this->renderPattern16(frame_time);
+			this->mapSegments<CRGB16, uint32_t>(leds16, this->pixel_data16);
+		};
+		
+	protected:
+		// Prefer reduced resolutions which are a multiple of every segment length (their least common multiple), so the faster integer
+		// multiple interpolation can be used for all segments. If there is none within the minimum resolution, prefer a multiple of the
+		// first segment length, so it can at least be used for segments of that length
+		uint16_t snapResolution(uint16_t resolution) const override {
+			uint32_t common_len = 1;
+			for (uint8_t seg_id=0; seg_id < this->num_segments && common_len <= resolution; seg_id++) {
+				uint16_t seg_len = this->strip_segments[seg_id].segment_len;
+				common_len = common_len / greatest_common_divisor(common_len, seg_len) * seg_len;
+			}
+			if (common_len <= resolution) {
+				uint16_t snapped = (resolution / common_len) * common_len;
+				if (snapped >= this->min_pixels) {
+					return snapped;
+				}
+			}
+			uint16_t seg_len = this->strip_segments[0].segment_len;
+			uint16_t snapped = (resolution / seg_len) * seg_len;
+			return (snapped > 0 && snapped >= this->min_pixels) ? snapped : resolution;
+		}
+
+		// Map pattern pixels to all registered strip segments (will be scaled to each segment length)
+		// PixelT is the pixel type (CRGB or CRGB16), and SumT is used to sum colour components when downsampling
+		template<typename PixelT, typename SumT>
+		void mapSegments(PixelT* leds, const PixelT* pixel_data) const {
 			uint16_t pat_len = this->num_pixels;
-			// Map pattern to all registered strip segments (will be scaled to each segment length)
+			if (this->power_meter != nullptr) {
+				this->power_meter->beginMapping();
+			}
 			for (uint8_t seg_id=0; seg_id < this->num_segments; seg_id++) {
 				StripSegment& strip_segment = this->strip_segments[seg_id];
 
 				if (strip_segment.segment_len == pat_len) {
 					// When segment length is equal to pattern pixel resolution, no need to downsample.
-					interpolate_equal_length(leds, strip_segment);
+					interpolate_equal_length(leds, pixel_data, strip_segment, seg_id);
 				} else if (pat_len % strip_segment.segment_len == 0) {
 					// Optimisation for when pattern length is an integer multiple of the segment length
-					interpolate_integer_multiple_length(leds, strip_segment);
+					interpolate_integer_multiple_length<PixelT, SumT>(leds, pixel_data, strip_segment, seg_id);
 				} else {
 					// General case of interpolating arbitrary length pattern data (resolution) to strip segment
-					interpolate_arbitrary_length(leds, strip_segment);
+					interpolate_arbitrary_length<PixelT, SumT>(leds, pixel_data, strip_segment, seg_id);
 				}			
 			}
-		};
-		
-	protected:
+		}
+
 		// Interpolate pattern pixel data to the provided strip segment, when pattern length (resolution) is equal to segment length
-		void interpolate_equal_length(CRGB* leds, StripSegment& strip_segment) const {
+		template<typename PixelT>
+		void interpolate_equal_length(PixelT* leds, const PixelT* pixel_data, StripSegment& strip_segment, uint8_t seg_id) const {
 			for (uint16_t led_seg_ind=0; led_seg_ind<strip_segment.segment_len; led_seg_ind++) 	{		
 				// Get LED strip index for LED 
 				uint16_t led_strip_ind = strip_segment.getLEDId(led_seg_ind);				
 				// Can translate directly from virtual pixels to segment LED
-				leds[led_strip_ind] = this->pixel_data[led_seg_ind];
+				this->setLED(leds, led_strip_ind, pixel_data[led_seg_ind]);
+				this->meterLED(seg_id, led_strip_ind, pixel_data[led_seg_ind]);
 			}
 		};
 
 		// Interpolate pattern pixel data to the provided strip segment, when pattern length (resolution) is an integer multiple of segment length
-		void interpolate_integer_multiple_length(CRGB* leds, StripSegment& strip_segment) const {
+		template<typename PixelT, typename SumT>
+		void interpolate_integer_multiple_length(PixelT* leds, const PixelT* pixel_data, StripSegment& strip_segment, uint8_t seg_id) const {
 			uint8_t scale_factor = this->num_pixels / strip_segment.segment_len;
 			for (uint16_t led_seg_ind=0; led_seg_ind<strip_segment.segment_len; led_seg_ind++) 	{		
 				// Get LED strip index for LED 
 				uint16_t led_strip_ind = strip_segment.getLEDId(led_seg_ind);	
 				// Sum RGB values over all pattern pixels for the segment LED, then divide by count to get average
-				uint16_t r = 0, g = 0, b = 0;
+				SumT r = 0, g = 0, b = 0;
 				uint16_t start_pixel_id = scale_factor*led_seg_ind;
 				for (uint16_t pixel_id = start_pixel_id; pixel_id < start_pixel_id + scale_factor; pixel_id++)	{
-					CRGB led_val = this->pixel_data[pixel_id];
-					r += led_val.red;
-					g += led_val.green;
-					b += led_val.blue;
+					const PixelT& led_val = pixel_data[pixel_id];
+					r += led_val.r;
+					g += led_val.g;
+					b += led_val.b;
 				};
 				
-				leds[led_strip_ind] = CRGB(r/scale_factor, g/scale_factor, b/scale_factor);
+				PixelT value(r/scale_factor, g/scale_factor, b/scale_factor);
+				this->setLED(leds, led_strip_ind, value);
+				this->meterLED(seg_id, led_strip_ind, value);
 			}
 		};
 
 		// Interpolate pattern pixel data to the provided strip segment, for an arbitrary pattern length (resolution)
-		void interpolate_arbitrary_length(CRGB* leds, StripSegment& strip_segment) const	{
+		template<typename PixelT, typename SumT>
+		void interpolate_arbitrary_length(PixelT* leds, const PixelT* pixel_data, StripSegment& strip_segment, uint8_t seg_id) const	{
 			uint16_t seg_len = strip_segment.segment_len;
 			uint16_t pat_len = this->num_pixels;
 			for (uint16_t led_seg_ind=0; led_seg_ind<strip_segment.segment_len; led_seg_ind++) 	{		
@@ -136,11 +381,11 @@ class LinearPatternMapper: public BaseLinearPatternMapper {
 				uint16_t first_weight = seg_len - (led_seg_ind*pat_len - start_index*seg_len);
 				uint16_t remaining_weight = pat_len;
 				// Cumulative RGB colour values 
-				uint16_t r = 0, g = 0, b = 0;
+				SumT r = 0, g = 0, b = 0;
 				// Add weighted values to colour components from pattern state
 				uint16_t pat_ind = start_index;
 				do {
-					CRGB led_val = this->pixel_data[pat_ind];
+					const PixelT& led_val = pixel_data[pat_ind];
 					uint16_t weight;
 					if (pat_ind == start_index) {
 						weight = first_weight;
@@ -149,16 +394,18 @@ class LinearPatternMapper: public BaseLinearPatternMapper {
 					} else {
 						weight = remaining_weight;
 					}
-					r += weight*led_val.red;
-					g += weight*led_val.green;
-					b += weight*led_val.blue;
+					r += (SumT) weight*led_val.r;
+					g += (SumT) weight*led_val.g;
+					b += (SumT) weight*led_val.b;
 					pat_ind += 1;
 					remaining_weight -= weight;
 					
 				} while (remaining_weight>0);
 
 				// Assign downsampled pixel value					
-				leds[led_strip_ind] = CRGB(r/pat_len, g/pat_len, b/pat_len);
+				PixelT value(r/pat_len, g/pat_len, b/pat_len);
+				this->setLED(leds, led_strip_ind, value);
+				this->meterLED(seg_id, led_strip_ind, value);
 			}
 		};
 
@@ -168,6 +415,112 @@ class LinearPatternMapper: public BaseLinearPatternMapper {
 };
 
 
+// Maps a LinearPattern to strip segments (as LinearPatternMapper) using palette indexed pixel arrays instead of a CRGB pixel array, for
+// boards with little RAM. The pattern sets a colour picker index (and optionally a brightness) for each pixel with frameActionIndexed(),
+// which is only resolved to a colour when the LED is written, so the pattern needs 1 or 2 bytes per pixel instead of 3, and pixels which
+// are merged by downsampling don't need a palette lookup. The pattern must support frameActionIndexed() (segments are black if it doesn't).
+// Each LED uses the index of the pattern pixel nearest its centre (indices aren't averaged, as palettes aren't always continuous),
+// and the average brightness of the pattern pixels it covers. Frame caches and 16 bit pixel arrays are not used
+class IndexedLinearPatternMapper: public LinearPatternMapper {
+	public:
+		IndexedLinearPatternMapper(
+			LinearPattern& pattern,   				// LinearPattern to map to segments
+			uint8_t* indices,						// Colour index array for LinearPattern to mutate (length equal to num_pixels)
+			uint8_t* brightness,					// Brightness array for LinearPattern to mutate (length equal to num_pixels), or nullptr if pattern only needs indices
+			uint16_t num_pixels,					// Number of pixels for linear pattern to use (pattern resolution)
+			StripSegment strip_segments[],			// Array of StripSegments to map pattern to
+			uint8_t num_segments					// Number of axes (length of strip_segments)
+		): 
+		LinearPatternMapper(pattern, nullptr, num_pixels, strip_segments, num_segments),
+		indices(indices),
+		brightness(brightness) {}
+
+		void reset() const override {
+			memset(this->indices, 0, this->max_pixels);
+			if (this->brightness != nullptr) {
+				memset(this->brightness, 0, this->max_pixels);
+			}
+			LinearPatternMapper::reset();
+		}
+
+		void reportMemory(MemoryReport& report) const override {
+			LinearPatternMapper::reportMemory(report);
+			report.pixel_buffers += this->brightness != nullptr ? 2*this->max_pixels : this->max_pixels;
+		}
+
+		void warmFrame(uint16_t frame_time) const override {
+			this->renderIndexed(frame_time);
+		}
+
+		void newFrame(CRGB* leds, uint16_t frame_time) const override {
+			bool rendered = this->renderIndexed(frame_time);
+			uint16_t pat_len = this->num_pixels;
+			if (this->power_meter != nullptr) {
+				this->power_meter->beginMapping();
+			}
+			for (uint8_t seg_id=0; seg_id < this->num_segments; seg_id++) {
+				StripSegment& strip_segment = this->strip_segments[seg_id];
+				uint16_t seg_len = strip_segment.segment_len;
+				for (uint16_t led_seg_ind=0; led_seg_ind < seg_len; led_seg_ind++) {
+					uint16_t led_strip_ind = strip_segment.getLEDId(led_seg_ind);
+					if (!rendered) {
+						this->setLED(leds, led_strip_ind, CRGB(CRGB::Black));
+						this->meterLED(seg_id, led_strip_ind, CRGB(CRGB::Black));
+						continue;
+					}
+					// Pattern pixel nearest to centre of LED
+					uint16_t centre_index = ((uint32_t) (2*led_seg_ind + 1)*pat_len)/(2*seg_len);
+					uint8_t bright = 255;
+					if (this->brightness != nullptr) {
+						// Average brightness over pattern pixels covered by LED (at least one, when upsampling)
+						uint16_t start_index = ((uint32_t) led_seg_ind*pat_len)/seg_len;
+						uint16_t end_index = ((uint32_t) (led_seg_ind + 1)*pat_len)/seg_len;
+						if (end_index <= start_index) {
+							end_index = start_index + 1;
+						}
+						uint32_t sum = 0;
+						for (uint16_t pat_ind=start_index; pat_ind < end_index; pat_ind++) {
+							sum += this->brightness[pat_ind];
+						}
+						bright = sum/(end_index - start_index);
+					}
+					CRGB value = bright ? this->pattern.indexedColor(this->indices[centre_index], bright) : CRGB(CRGB::Black);
+					this->setLED(leds, led_strip_ind, value);
+					this->meterLED(seg_id, led_strip_ind, value);
+				}
+			}
+		}
+
+		// Indexed pixels are resolved to 8 bit colours, so there is no precision to keep
+		void newFrame16(CRGB16* leds16, CRGB* leds, uint16_t num_leds, uint16_t frame_time) const override {
+			BasePatternMapper::newFrame16(leds16, leds, num_leds, frame_time);
+		}
+
+	protected:
+		// Run pattern logic to populate indices (and brightness). Returns false if the pattern doesn't support indexed pixels
+		bool renderIndexed(uint16_t frame_time) const {
+			return this->pattern.frameActionIndexed(this->indices, this->brightness, this->num_pixels, frame_time);
+		}
+
+		uint8_t* indices;
+		uint8_t* brightness;				// Optional brightness array
+};
+
+// RAM used by an array of SpatialStripSegments (including their StripSegments and LED positions)
+size_t spatial_segments_memory_usage(SpatialStripSegment_T** spatial_segments, uint8_t num_segments) {
+	size_t size = num_segments*sizeof(SpatialStripSegment_T*);
+	for (uint8_t i=0; i < num_segments; i++) {
+		size += spatial_segments[i]->memoryUsage() + sizeof(StripSegment);
+	}
+	return size;
+}
+
+// Order in which LEDs are assigned to the fields of an interlaced mapping (see SpatialPatternMapper::setInterlace())
+enum InterlaceOrder {
+	INTERLACE_STRIDED,			// Every Nth LED is in the same field (LED index modulo N)
+	INTERLACE_BLUE_NOISE		// LEDs are spread between fields using a golden ratio sequence, so neighbouring LEDs are updated on well separated frames (less visible scanning)
+};
+
 // Class for handling the mapping of a 3DPattern to set of segments with spatial positioning
 // The SpatialPattern has its own coordinate system (bounds of +/- resolution on each axis),
 // and there is also the physical project coordinate system (the spatial positions of LEDS as defined in SpatialStripSegments)
@@ -195,7 +548,12 @@ class SpatialPatternMapper: public BasePatternMapper {
 			// Set automatically if not specified (scale project bounds to fit pattern space)
 			if (this->scale_factors == undefinedPoint) {
 				this->scale_factors = (2.0*pattern.resolution)/project_bounds.magnitude();
-
+				// Flat projects have no extent on some axes, so use the smallest scale of the other axes for them
+				// (otherwise coordinates on that axis are infinite, which breaks rotation of the pattern)
+				float min_scale = min(this->scale_factors.x, min(this->scale_factors.y, this->scale_factors.z));
+				if (isinf(this->scale_factors.x)) this->scale_factors.x = min_scale;
+				if (isinf(this->scale_factors.y)) this->scale_factors.y = min_scale;
+				if (isinf(this->scale_factors.z)) this->scale_factors.z = min_scale;
 			}
 			// Default offset to centre of project bounds so it is translated to be centered on origin of pattern space
 			if (this->offset == undefinedPoint) {
@@ -207,27 +565,191 @@ class SpatialPatternMapper: public BasePatternMapper {
 		void reset() const override {		
 			BasePatternMapper::reset();
 			this->pattern.reset();
+			// First frame after reset always updates every LED
+			this->field = 0;
+			this->full_frame = true;
+			// Transformed coordinates may have been overwritten by another mapping sharing the buffer
+			this->transform_valid = false;
 		};
+
+		// Pre-calculate the pattern coordinates of every LED into a PointBuffer, so positions are not looked up and transformed
+		// for each LED on every frame. Buffer capacity must be at least the total length of the segments, otherwise it is not used.
+		// When the pattern is animated (see setRotation()), a second buffer of the same capacity can be given to hold the
+		// transformed coordinates, so that the transformation is applied to all LEDs in one pass
+		void setPointBuffer(PointBuffer_T* point_buffer, PointBuffer_T* transformed_points=nullptr) {
+			this->point_buffer = nullptr;
+			this->transformed_points = nullptr;
+			this->transform_valid = false;
+			if (point_buffer != nullptr && point_buffer->loadSegments(this->spatial_segments, this->num_segments)) {
+				point_buffer->offsetScale(this->offset, this->scale_factors);
+				this->point_buffer = point_buffer;
+				this->transformed_points = transformed_points;
+			}
+		}
+
+		// Animate pattern by rotating it about an axis through the pattern origin (centre of the project by default)
+		void setRotation(
+			Point axis,				// Axis of rotation (in pattern coordinates)
+			float speed				// Speed of rotation (in degrees per second, negative to reverse)
+		) {
+			this->rotation = AxisRotation(axis);
+			this->rotation_speed = speed*(PI/180000.0);
+			this->transform_function = nullptr;
+			this->animated = true;
+			this->transform_valid = false;
+		}
+
+		// Animate pattern with a function giving the transformation to apply to pattern coordinates for each frame time
+		// (e.g. rotation with a Quaternion, movement or scaling). Set to nullptr to stop animating
+		void setTransformFunction(TransformFunction transform_function) {
+			this->transform_function = transform_function;
+			this->animated = transform_function != nullptr;
+			this->transform_valid = false;
+		}
+
+		// Enable interlaced mode, where the LEDs are split into 'fields' subsets and only one subset is evaluated each frame (rotating through them).
+		// The rest of the LEDs keep their previous value, so slow moving patterns look the same while rendering N times faster
+		void setInterlace(
+			uint8_t fields,									// Number of subsets of LEDs (1 to disable interlacing)
+			InterlaceOrder order=INTERLACE_STRIDED			// Order in which LEDs are assigned to subsets
+		) {
+			this->fields = fields > 0 ? fields : 1;
+			this->interlace_order = order;
+			this->render_budget = 0;
+		}
+
+		// Enable interlaced mode with the number of fields chosen automatically, so that evaluating the pattern for the LEDs
+		// takes at most budget_us each frame. The render time of each frame is measured to estimate the time for all LEDs
+		void setInterlaceBudget(
+			uint16_t budget_us,								// Target time to spend evaluating LEDs each frame (in us)
+			uint8_t max_fields=8,							// Maximum number of fields
+			InterlaceOrder order=INTERLACE_BLUE_NOISE		// Order in which LEDs are assigned to subsets
+		) {
+			this->setInterlace(1, order);
+			this->render_budget = budget_us;
+			this->max_fields = max_fields > 0 ? max_fields : 1;
+			this->render_estimate = 0;
+		}
+
+		// Current number of interlaced fields
+		uint8_t getInterlaceFields() const {
+			return this->fields;
+		}
+
+		LayerState getLayerState() const override {
+			// When interlaced, some LEDs still have values from previous frames
+			return this->fields == 1 ? this->pattern.getLayerState() : LAYER_PARTIAL;
+		}
+
+		bool isSeekable() const override {
+			return this->pattern.isSeekable();
+		}
+
+		// LEDs are only added when every LED is written (when not interlaced), otherwise the controller measures the LED array
+		bool setPowerMeter(PowerMeter_T* power_meter) override {
+			this->power_meter = power_meter;
+			return true;
+		}
+
+		void reportMemory(MemoryReport& report) const override {
+			report.mappings += sizeof(*this);
+			report.segments += spatial_segments_memory_usage(this->spatial_segments, this->num_segments);
+			if (this->point_buffer != nullptr) {
+				report.pixel_buffers += this->point_buffer->memoryUsage();
+			}
+			if (this->transformed_points != nullptr) {
+				report.pixel_buffers += this->transformed_points->memoryUsage();
+			}
+			this->pattern.reportMemory(report);
+		}
+
+		void warmFrame(uint16_t frame_time) const override {
+			this->pattern.frameAction(frame_time);
+		}
+
+		// Set value of a parameter of the pattern
+		void setPatternParameter(uint8_t param_id, int32_t value) const override {
+			this->pattern.setParameter(param_id, value);
+		}
+
+		// Reduced quality only evaluates the pattern for every 2nd, 3rd or 4th LED along each segment,
+		// and the LEDs in between are given the same value
+		void setQuality(uint8_t quality) const override {
+			this->led_step = limit(256/(quality+1), 4);
+		}
 		
 		// Excute new frame of pattern and map results to LED array
 		void newFrame(CRGB* leds, uint16_t frame_time) const override {
 			// Run pattern frame logic
 			this->pattern.frameAction(frame_time);
+			// Render time is only measured when the number of fields is automatic
+			uint32_t render_start = this->render_budget ? micros() : 0;
+			// Animated transformation of pattern coordinates, applied to all LEDs in one pass if there is a buffer for the results
+			const PointBuffer_T* points = this->point_buffer;
+			AffineTransform transform;
+			bool transform_each = false;
+			if (this->animated) {
+				transform = this->transform_function != nullptr ? this->transform_function(frame_time) : this->rotation.at(this->rotation_speed*frame_time);
+				if (this->transformed_points != nullptr) {
+					// Coordinates only need updating if transformation has changed since last frame
+					if (!this->transform_valid || transform != this->last_transform) {
+						this->point_buffer->transform(transform, *this->transformed_points);
+						this->last_transform = transform;
+						this->transform_valid = true;
+					}
+					points = this->transformed_points;
+				} else {
+					transform_each = true;
+				}
+			}
+			// Fields to render this frame, LEDs not in the current field are skipped
+			uint8_t fields = this->full_frame ? 1 : this->fields;
+			// LEDs from previous frames are not known to the power meter, so it can only be used for full frames
+			bool metered = fields == 1 && this->power_meter != nullptr;
+			if (metered) {
+				this->power_meter->beginMapping();
+			}
+			uint16_t led_index = 0;
+			uint16_t segment_start = 0;		// Index of first LED of segment in point buffer
 			// Loop through every LED (segment and segment index combination), determine spatial position and get value
 			for (uint8_t segment_id=0; segment_id < this->num_segments; segment_id++) {
 				SpatialStripSegment_T* spatial_segment = this->spatial_segments[segment_id];
+				uint16_t segment_len = spatial_segment->strip_segment.segment_len;
 				// Loop through all positions on axis
-				for (uint16_t segment_pos=0; segment_pos < spatial_segment->strip_segment.segment_len; segment_pos++) {
-					// Get position from spatial axis
-					Point pos = spatial_segment->getSpatialPosition(segment_pos);
-					// Get LED ID from strip segment
-					uint16_t led_id = spatial_segment->strip_segment.getLEDId(segment_pos);
-					// Translate spatial position to pattern coordinates
-					Point pattern_pos = ((pos - this->offset)).hadamard_product(this->scale_factors);
-					// Get and assign LED value from pattern
-					leds[led_id] = this->pattern.getPixelValue(pattern_pos);
+				for (uint16_t segment_pos=0; segment_pos < segment_len; segment_pos += this->led_step, led_index++) {
+					if (fields > 1 && this->getField(led_index, fields) != this->field) {
+						continue;
+					}
+					Point pattern_pos;
+					if (points != nullptr) {
+						pattern_pos = points->get(segment_start + segment_pos);
+					} else {
+						// Get position from spatial axis
+						Point pos = spatial_segment->getSpatialPosition(segment_pos);
+						// Translate spatial position to pattern coordinates
+						pattern_pos = ((pos - this->offset)).hadamard_product(this->scale_factors);
+					}
+					if (transform_each) {
+						pattern_pos = transform.apply(pattern_pos);
+					}
+					// Get LED value from pattern
+					CRGB value = this->pattern.getPixelValue(pattern_pos);
+					// Assign to LED (and following skipped LEDs) using LED ID from strip segment
+					for (uint16_t pos_id=segment_pos; pos_id < segment_pos + this->led_step && pos_id < segment_len; pos_id++) {
+						uint16_t led_id = spatial_segment->strip_segment.getLEDId(pos_id);
+						this->setLED(leds, led_id, value);
+						if (metered) {
+							this->meterLED(segment_id, led_id, value);
+						}
+					}
 				}
+				segment_start += segment_len;
 			}
+			if (this->render_budget) {
+				this->adjustFields(micros() - render_start, fields);
+			}
+			this->full_frame = false;
+			this->field = (this->field + 1) % this->fields;
 		};
 		
 	protected:
@@ -237,6 +759,41 @@ class SpatialPatternMapper: public BasePatternMapper {
 		Point offset;  					// Offset of Pattern space from Project space (in Project coordinates, before scaling applied)
 		Point scale_factors; 			// Scaling vector for Project space to Pattern space transformation
 		Point project_centroid; 		// Centre point of project coordinate bounds
+		mutable uint8_t led_step=1;		// Number of LEDs along segment that each pattern evaluation is applied to (1 at full quality)
+		PointBuffer_T* point_buffer=nullptr;	// Optional pre-calculated pattern coordinates of every LED
+		PointBuffer_T* transformed_points=nullptr;	// Optional buffer for animated pattern coordinates of every LED
+		bool animated=false;					// Whether pattern coordinates are transformed every frame
+		AxisRotation rotation;					// Rotation applied if animated without a transform_function
+		float rotation_speed=0;					// Speed of rotation (in radians per ms)
+		TransformFunction transform_function=nullptr;	// Function giving transformation for each frame time
+		mutable AffineTransform last_transform;		// Transformation applied to transformed_points
+		mutable bool transform_valid=false;			// Whether transformed_points holds the result of last_transform
+
+		// Get interlaced field of an LED
+		uint8_t getField(uint16_t led_index, uint8_t fields) const {
+			if (this->interlace_order == INTERLACE_STRIDED) {
+				return led_index % fields;
+			}
+			// Fractional part of led_index/golden ratio (16 bit fixed point), scaled to number of fields
+			return ((uint32_t) ((uint16_t) (led_index*40503U)) * fields) >> 16;
+		}
+
+		// Choose number of fields for the next frames from the render time of the last frame (for 'fields_rendered' fields)
+		void adjustFields(uint32_t render_time, uint8_t fields_rendered) const {
+			// Smoothed estimate of time to render all LEDs
+			uint32_t full_time = render_time*fields_rendered;
+			this->render_estimate = this->render_estimate ? (3*this->render_estimate + full_time)/4 : full_time;
+			uint32_t fields = (this->render_estimate + this->render_budget - 1)/this->render_budget;
+			this->fields = constrain(fields, 1, this->max_fields);
+		}
+
+		mutable uint8_t fields=1;					// Number of interlaced fields (1 when not interlaced)
+		mutable uint8_t field=0;					// Field to render in next frame
+		mutable bool full_frame=true;				// Whether next frame should render all fields
+		InterlaceOrder interlace_order=INTERLACE_STRIDED;
+		uint16_t render_budget=0;					// Time budget for evaluating LEDs each frame when number of fields is automatic (in us, 0 if fixed)
+		uint8_t max_fields=1;						// Maximum number of fields when automatic
+		mutable uint32_t render_estimate=0;			// Smoothed estimate of time to evaluate all LEDs (in us)
 };
 
 // Allows for mapping a linear pattern to a vector (linear path/direction) in 3D space
@@ -283,14 +840,28 @@ class LinearToSpatialPatternMapper : public BaseLinearPatternMapper {
 			this->plane_eq_D = pattern_vector.x*this->path_start_pos.x + pattern_vector.y*this->path_start_pos.y + pattern_vector.z*this->path_start_pos.z;
 			// Pre-calculate inverse of pattern vector norm
 			this->inv_pattern_vect_norm = 1/vector_len;
-			// Pre-calculate pattern resolution / length constant
-			this->res_per_len = ((float) this->num_pixels-1.0)/this->path_length;
 		};
 		
+		void reportMemory(MemoryReport& report) const override {
+			report.mappings += sizeof(*this);
+			report.segments += spatial_segments_memory_usage(this->spatial_segments, this->num_segments);
+			this->reportPatternMemory(report);
+		}
+
+		bool setPowerMeter(PowerMeter_T* power_meter) override {
+			this->power_meter = power_meter;
+			return true;
+		}
+
 		// Excute new frame of pattern and map results to LED array
 		void newFrame(CRGB* leds, uint16_t frame_time) const override {
 			// Run pattern logic
-			this->pattern.frameAction(this->pixel_data, this->num_pixels, frame_time);
+			this->renderPattern(frame_time);
+			if (this->power_meter != nullptr) {
+				this->power_meter->beginMapping();
+			}
+			// Pattern resolution / length constant (calculated each frame since resolution can change)
+			float res_per_len = ((float) this->num_pixels-1.0)/this->path_length;
 			// Loop through every LED (axis and axis position combination), determine spatial position and appropriate state from pattern
 			for (uint8_t segment_id=0; segment_id < this->num_segments; segment_id++) {
 				SpatialStripSegment_T* spatial_axis = this->spatial_segments[segment_id];
@@ -307,21 +878,25 @@ class LinearToSpatialPatternMapper : public BaseLinearPatternMapper {
 						if (!between(pos_on_path.x, this->path_start_pos.x, this->path_end_pos.x) || 
 							!between(pos_on_path.y, this->path_start_pos.y, this->path_end_pos.y) || 
 							!between(pos_on_path.y, this->path_start_pos.z, this->path_end_pos.z)) {
-							leds[led_id] = CRGB::Black;
+							this->setLED(leds, led_id, CRGB(CRGB::Black));
+							this->meterLED(segment_id, led_id, CRGB(CRGB::Black));
 							continue;
 						}
 					}
 					// Get distance of LED from plane through pattern path start position (use pre-calculated constants instead of Point.distance_to_plane() for efficiency)
 					uint16_t dist_from_start = abs(this->pattern_vector.x*led_pos.x + this->pattern_vector.y*led_pos.y + this->pattern_vector.z*led_pos.z - this->plane_eq_D) * this->inv_pattern_vect_norm;
+					CRGB value;
 					if (dist_from_start > this->path_length) {
 						// All LEDS beyond the end of the path should be set to black
-						leds[led_id] = CRGB::Black;
+						value = CRGB::Black;
 					} else {
 						// Get pattern value at same proportional position along pattern axis
 						// For now just round to nearest, could do interpolation between two
-						uint16_t pattern_axis_pos = round(dist_from_start*this->res_per_len);
-						leds[led_id] = this->pixel_data[pattern_axis_pos];
+						uint16_t pattern_axis_pos = round(dist_from_start*res_per_len);
+						value = this->pixel_data[pattern_axis_pos];
 					}
+					this->setLED(leds, led_id, value);
+					this->meterLED(segment_id, led_id, value);
 				}
 			}
 		}
@@ -334,11 +909,221 @@ class LinearToSpatialPatternMapper : public BaseLinearPatternMapper {
 
 		Point path_start_pos, path_end_pos;
 		uint16_t path_length;				// Length of path that linear pattern will travel through
-		float plane_eq_D, inv_pattern_vect_norm, res_per_len;  // Pre-calculated constants for plane distance calculation
+		float plane_eq_D, inv_pattern_vect_norm;  // Pre-calculated constants for plane distance calculation
+};
+
+// Ways of projecting a linear pattern onto spatial LED positions (see ProjectedLinearPatternMapper)
+enum ProjectionMode {
+	PROJECT_RADIAL,				// Pattern runs outwards with distance from the centre (e.g. ripples)
+	PROJECT_CYLINDRICAL,		// Pattern runs around the axis with angle (e.g. pinwheels), wrapping from the end of the pattern back to the start
+	PROJECT_SPHERICAL			// Pattern runs with angle from the axis direction (0) to the opposite direction (end of pattern)
+};
+
+// Pre-calculated projection of an LED (see ProjectedLinearPatternMapper)
+struct ProjectionEntry {
+	uint16_t led_id;			// Index of LED in LED array
+	uint16_t position;			// Position of LED along pattern (16 bit fraction of pattern length)
+};
+
+// Maps a linear pattern onto spatial LED positions by distance from a centre point (radial), angle around an axis (cylindrical),
+// or angle from an axis (spherical). The LED index and pattern position of every LED is calculated once at construction
+// into a table, so each frame only gathers (and optionally blends) values from pixel_data without any per-LED trigonometry.
+// Positions are stored as fractions of the pattern length, so the table is still valid if the resolution is reduced
+class ProjectedLinearPatternMapper : public BaseLinearPatternMapper {
+	public:
+		// Constructor
+		ProjectedLinearPatternMapper(
+			LinearPattern& pattern,						// LinearPattern object
+			CRGB* pixel_data,							// Pixel array for LinearPattern to mutate (length equal to pattern resolution)
+			uint16_t num_pixels,						// Number of pixels for linear pattern to use (pattern resolution)
+			ProjectionMode mode,						// How pattern is projected onto LED positions
+			SpatialStripSegment_T* spatial_segments[],	// Array of SpatialStripSegments to map pattern to
+			uint8_t num_segments,						// Number of SpatialStripSegments (length of spatial_segments)
+			ProjectionEntry* projection_table,			// Array to store projection of each LED (length equal to total length of segments)
+			Point centre=undefinedPoint,				// Centre of projection (defaults to centre of bounds of segments)
+			Point axis=Point(0, 0, 1),					// Axis of rotation for cylindrical and spherical projections
+			uint8_t repeats=1,							// Number of times pattern is repeated around the axis (cylindrical projection)
+			bool interpolate=true						// Whether to blend between adjacent pattern pixels (otherwise use nearest)
+		):
+		BaseLinearPatternMapper(pattern, pixel_data, num_pixels),
+		projection_table(projection_table),
+		wrap(mode == PROJECT_CYLINDRICAL),
+		interpolate(interpolate) {
+			if (centre == undefinedPoint) {
+				centre = get_spatial_segment_bounds(spatial_segments, num_segments).centre();
+			}
+			Point unit_axis = axis/axis.norm();
+			// Reference directions perpendicular to the axis, for measuring angle around it
+			Point reference = fabs(unit_axis.x) < 0.9 ? v_x : v_y;
+			reference -= unit_axis*(reference.x*unit_axis.x + reference.y*unit_axis.y + reference.z*unit_axis.z);
+			reference /= reference.norm();
+			Point reference2(
+				unit_axis.y*reference.z - unit_axis.z*reference.y,
+				unit_axis.z*reference.x - unit_axis.x*reference.z,
+				unit_axis.x*reference.y - unit_axis.y*reference.x
+			);
+			// Radial positions are scaled so the furthest LED is at the end of the pattern
+			float max_distance = 0;
+			if (mode == PROJECT_RADIAL) {
+				for (uint8_t segment_id=0; segment_id < num_segments; segment_id++) {
+					SpatialStripSegment_T* spatial_segment = spatial_segments[segment_id];
+					for (uint16_t segment_pos=0; segment_pos < spatial_segment->strip_segment.segment_len; segment_pos++) {
+						max_distance = max(max_distance, (spatial_segment->getSpatialPosition(segment_pos) - centre).norm());
+					}
+				}
+			}
+			uint16_t num_leds = 0;
+			for (uint8_t segment_id=0; segment_id < num_segments; segment_id++) {
+				SpatialStripSegment_T* spatial_segment = spatial_segments[segment_id];
+				for (uint16_t segment_pos=0; segment_pos < spatial_segment->strip_segment.segment_len; segment_pos++, num_leds++) {
+					Point p = spatial_segment->getSpatialPosition(segment_pos) - centre;
+					// Fraction of pattern length
+					float fraction;
+					if (mode == PROJECT_RADIAL) {
+						fraction = max_distance > 0 ? p.norm()/max_distance : 0;
+					} else if (mode == PROJECT_CYLINDRICAL) {
+						// Fraction of full turn around axis
+						float angle = atan2(p.x*reference2.x + p.y*reference2.y + p.z*reference2.z, p.x*reference.x + p.y*reference.y + p.z*reference.z);
+						fraction = angle/(2*PI) + (angle < 0 ? 1 : 0);
+						fraction = fraction*repeats - floor(fraction*repeats);
+					} else {
+						// Fraction of angle from axis to opposite direction
+						float norm = p.norm();
+						fraction = norm > 0 ? acos(constrain((p.x*unit_axis.x + p.y*unit_axis.y + p.z*unit_axis.z)/norm, -1.0f, 1.0f))/PI : 0;
+					}
+					uint16_t position = this->wrap ? (uint16_t) (uint32_t) (fraction*65536) : (uint16_t) (constrain(fraction, 0.0f, 1.0f)*65535);
+					projection_table[num_leds] = ProjectionEntry{spatial_segment->strip_segment.getLEDId(segment_pos), position};
+				}
+			}
+			this->num_leds = num_leds;
+		}
+
+		void reportMemory(MemoryReport& report) const override {
+			report.mappings += sizeof(*this);
+			report.pixel_buffers += this->num_leds*sizeof(ProjectionEntry);
+			this->reportPatternMemory(report);
+		}
+
+		// Excute new frame of pattern and map results to LED array
+		void newFrame(CRGB* leds, uint16_t frame_time) const override {
+			this->renderPattern(frame_time);
+			// Pattern positions are scaled to num_pixels when wrapping around (position 0 follows the last pixel),
+			// otherwise the pattern ends at the last pixel
+			uint16_t num_pixels = this->num_pixels;
+			uint16_t scale = this->wrap ? num_pixels : num_pixels - 1;
+			for (uint16_t i=0; i < this->num_leds; i++) {
+				const ProjectionEntry& entry = this->projection_table[i];
+				uint32_t scaled = (uint32_t) entry.position*scale;
+				if (this->interpolate) {
+					uint16_t index = scaled >> 16;
+					uint16_t next_index = index + 1;
+					if (next_index >= num_pixels) {
+						next_index = this->wrap ? 0 : num_pixels - 1;
+					}
+					this->setLED(leds, entry.led_id, blend(this->pixel_data[index], this->pixel_data[next_index], (scaled >> 8) & 0xFF));
+				} else {
+					uint16_t index = (scaled + 0x8000) >> 16;
+					if (index >= num_pixels) {
+						index = this->wrap ? 0 : num_pixels - 1;
+					}
+					this->setLED(leds, entry.led_id, this->pixel_data[index]);
+				}
+			}
+		}
+
+	protected:
+		ProjectionEntry* projection_table;
+		uint16_t num_leds;						// Number of LEDs in projection table
+		const bool wrap;						// Whether pattern wraps around from the last pixel to the first
+		const bool interpolate;
+};
+
+// Handles the mapping of a MatrixPattern to an LED matrix
+// The pattern is rendered to a row-major pixel array with the same dimensions as the matrix, 
+// which is then copied to the LEDs using the pre-calculated lookup table of the MatrixLayout
+class MatrixPatternMapper: public BasePatternMapper {
+	public:
+		// Constructor
+		MatrixPatternMapper(
+			MatrixPattern& pattern,				// MatrixPattern to map to matrix
+			CRGB* pixel_data,					// Pixel array for MatrixPattern to mutate (length equal to layout width*height)
+			const MatrixLayout& layout			// Layout of LED matrix
+		):
+		pattern(pattern),
+		pixel_data(pixel_data),
+		layout(layout) {}
+
+		// Initialise/Reset pattern state
+		void reset() const override {
+			fill_solid(this->pixel_data, this->layout.size(), CRGB::Black);
+			this->pattern.reset();
+		}
+
+		// Set value of a parameter of the pattern
+		void setPatternParameter(uint8_t param_id, int32_t value) const override {
+			this->pattern.setParameter(param_id, value);
+		}
+
+		LayerState getLayerState() const override {
+			return this->pattern.getLayerState();
+		}
+
+		bool isSeekable() const override {
+			return this->pattern.isSeekable();
+		}
+
+		void reportMemory(MemoryReport& report) const override {
+			report.mappings += sizeof(*this) + sizeof(MatrixLayout);
+			report.pixel_buffers += pixel_buffer_size(this->layout.size()) + matrix_table_size(this->layout.width, this->layout.height);
+			this->pattern.reportMemory(report);
+		}
+
+		void warmFrame(uint16_t frame_time) const override {
+			this->pattern.frameAction(this->pixel_data, this->layout.width, this->layout.height, frame_time);
+		}
+
+		// Excute new frame of pattern and map results to LED array
+		void newFrame(CRGB* leds, uint16_t frame_time) const override {
+			this->pattern.frameAction(this->pixel_data, this->layout.width, this->layout.height, frame_time);
+			const uint16_t* led_table = this->layout.led_table;
+			for (uint16_t i=0; i < this->layout.size(); i++) {
+				this->setLED(leds, led_table[i], this->pixel_data[i]);
+			}
+		}
+
+	protected:
+		MatrixPattern& pattern;
+		CRGB* pixel_data;
+		const MatrixLayout& layout;
+};
+
+// Ways of combining a layer with the layers below it (see MultiplePatternMapper)
+enum BlendMode {
+	BLEND_OVER,				// Layer replaces layers below, except where it is black (transparent)
+	BLEND_ADD,				// Layer is added to layers below (saturating)
+	BLEND_MAX,				// Maximum of each colour channel of layer and layers below
+	BLEND_ALPHA,			// Layer is blended over layers below with the layer opacity, except where it is black (transparent)
+	BLEND_MULTIPLY,			// Layers below are multiplied by layer colour (white has no effect, black gives black)
+	BLEND_MASK				// Layers below are scaled by layer brightness (luma)
+};
+
+// Layer of a composited MultiplePatternMapper
+struct Layer {
+	BasePatternMapper* mapping;			// Mapping to render layer
+	CRGB* buffer;						// Buffer to render layer into (length equal to num_leds of MultiplePatternMapper)
+	BlendMode blend_mode;				// How layer is combined with layers below
+	uint8_t opacity;					// Opacity of layer for BLEND_ALPHA
 };
 
 // Allows for multiple pattern mappings to be applied at the same time
 // Can have multiple LinearPatternMapper or SpatialPatternMappings running concurrently on different parts of the same strip of LEDS
+// By default each mapping writes directly to the LED array, so where mappings overlap the last one to write an LED wins.
+// Alternatively, mappings can be composited as layers: each layer renders into its own buffer covering a compact range of LEDs,
+// then a single pass over the range combines the layers (from first to last) with their blend modes and writes the result to the LEDs.
+// Layers which report that their frame is empty (LAYER_EMPTY) or that they hide all layers below (LAYER_OPAQUE) are skipped where possible.
+// LAYER_OPAQUE is only valid for a layer whose mapping covers every LED in the range. Layer mappings only write the LEDs
+// within the range (see BasePatternMapper::setLEDWindow()), so their segments can extend beyond it.
+// A MultiplePatternMapper can itself be a layer (or one of the mappings) of another MultiplePatternMapper
 class MultiplePatternMapper : public BasePatternMapper {
 	public:
 		// Constructor
@@ -349,22 +1134,171 @@ class MultiplePatternMapper : public BasePatternMapper {
 		mappings(mappings), 
 		num_mappings(num_mappings)	{}
 
+		// Constructor for compositing mappings as layers
+		MultiplePatternMapper(
+			Layer* layers,								// Array of layers, from bottom to top
+			uint8_t num_layers,							// Number of layers (length of layers). Only the first 32 can be skipped when empty
+			uint16_t led_offset,						// Index of first LED covered by the layers
+			uint16_t num_leds							// Number of LEDs covered by the layers (length of each layer buffer)
+		):
+		mappings(nullptr),
+		num_mappings(num_layers),
+		layers(layers),
+		led_offset(led_offset),
+		num_leds(num_leds) {}
+
 		// Initialise/Reset pattern state
 		void reset() const override {	
 			for (uint8_t i=0; i < this->num_mappings; i++) {
-				this->mappings[i]->reset();
+				this->getMapping(i)->reset();
+				if (this->layers != nullptr) {
+					fill_solid(this->layers[i].buffer, this->num_leds, CRGB::Black);
+				}
+			}
+		};
+
+		// Set value of a parameter of the patterns of all mappings
+		void setPatternParameter(uint8_t param_id, int32_t value) const override {
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				this->getMapping(i)->setPatternParameter(param_id, value);
+			}
+		};
+
+		// Set rendering quality of all mappings
+		void setQuality(uint8_t quality) const override {
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				this->getMapping(i)->setQuality(quality);
+			}
+		};
+
+		void warmFrame(uint16_t frame_time) const override {
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				this->getMapping(i)->warmFrame(frame_time);
+			}
+		};
+
+		// Seekable if all mappings are seekable
+		bool isSeekable() const override {
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				if (!this->getMapping(i)->isSeekable()) {
+					return false;
+				}
 			}
+			return true;
 		};
+
+		void reportMemory(MemoryReport& report) const override {
+			report.mappings += sizeof(*this);
+			for (uint8_t i=0; i < this->num_mappings; i++) {
+				this->getMapping(i)->reportMemory(report);
+			}
+			if (this->layers == nullptr) {
+				report.mappings += this->num_mappings*sizeof(BasePatternMapper*);
+			} else {
+				report.mappings += this->num_mappings*sizeof(Layer);
+				report.pixel_buffers += this->num_mappings*pixel_buffer_size(this->num_leds);
+			}
+		}
 		
+		// Restrict LED writes to the window. Mappings writing directly to the LED array are given the same window, while layers
+		// still render the whole range into their buffers, and only the composited LEDs within the window are written
+		void setLEDWindow(uint16_t led_offset, uint16_t num_leds) override {
+			BasePatternMapper::setLEDWindow(led_offset, num_leds);
+			if (this->layers == nullptr) {
+				for (uint8_t i=0; i < this->num_mappings; i++) {
+					this->mappings[i]->setLEDWindow(led_offset, num_leds);
+				}
+			}
+		}
+
 		// Excute new frame of all pattern mappings
 		void newFrame(CRGB* leds, uint16_t frame_time) const override {
-			for (uint8_t i=0; i < this->num_mappings; i++) {				
-				this->mappings[i]->newFrame(leds, frame_time);
+			if (this->layers == nullptr) {
+				for (uint8_t i=0; i < this->num_mappings; i++) {				
+					this->mappings[i]->newFrame(leds, frame_time);
+				}
+			} else {
+				this->compositeFrame(leds, frame_time);
 			}
 		};
 
 	protected:
+		BasePatternMapper* getMapping(uint8_t i) const {
+			return this->layers == nullptr ? this->mappings[i] : this->layers[i].mapping;
+		}
+
+		// Render layers into their buffers, then combine them into the LED array
+		void compositeFrame(CRGB* leds, uint16_t frame_time) const {
+			// Layers below first_layer are hidden, and layers in skip_layers have no effect
+			uint8_t first_layer = 0;
+			uint32_t skip_layers = 0;
+			// Render from the top layer down, so layers hidden by a layer above are not rendered
+			uint8_t i = this->num_mappings;
+			while (i > first_layer) {
+				i--;
+				const Layer& layer = this->layers[i];
+				// Render into layer buffer, which covers the LEDs from led_offset
+				layer.mapping->setLEDWindow(this->led_offset, this->num_leds);
+				layer.mapping->newFrame(layer.buffer, frame_time);
+				layer.mapping->clearLEDWindow();
+				LayerState state = layer.mapping->getLayerState();
+				if (state == LAYER_OPAQUE && (layer.blend_mode == BLEND_OVER || (layer.blend_mode == BLEND_ALPHA && layer.opacity == 255))) {
+					first_layer = i;
+				} else if (state == LAYER_EMPTY) {
+					if (layer.blend_mode == BLEND_MULTIPLY || layer.blend_mode == BLEND_MASK) {
+						// Everything below is blacked out
+						first_layer = i + 1;
+					} else if (i < 32) {
+						skip_layers |= 1UL << i;
+					}
+				}
+			}
+			// Hidden layers still run their pattern logic, so they continue from the right state when uncovered
+			for (uint8_t hidden=0; hidden < i; hidden++) {
+				this->layers[hidden].mapping->warmFrame(frame_time);
+			}
+			// Write the LEDs covered by both the layers and the LED window (set when this mapping is a layer itself)
+			uint16_t start = max(this->led_offset, this->window_offset);
+			uint32_t end = min((uint32_t) this->led_offset + this->num_leds, (uint32_t) this->window_offset + this->window_leds);
+			for (uint32_t led_id=start; led_id < end; led_id++) {
+				uint16_t led = led_id - this->led_offset;
+				CRGB pixel = CRGB::Black;
+				for (i=first_layer; i < this->num_mappings; i++) {
+					if (!(i < 32 && (skip_layers & (1UL << i)))) {
+						blendPixel(pixel, this->layers[i].buffer[led], this->layers[i]);
+					}
+				}
+				leds[led_id - this->window_offset] = pixel;
+			}
+		}
+
+		// Combine layer value into pixel
+		static void blendPixel(CRGB& pixel, const CRGB& value, const Layer& layer) {
+			switch (layer.blend_mode) {
+				case BLEND_OVER:
+					if (value) pixel = value;
+					break;
+				case BLEND_ADD:
+					pixel += value;
+					break;
+				case BLEND_MAX:
+					pixel = CRGB(max(pixel.r, value.r), max(pixel.g, value.g), max(pixel.b, value.b));
+					break;
+				case BLEND_ALPHA:
+					if (value) nblend(pixel, value, layer.opacity);
+					break;
+				case BLEND_MULTIPLY:
+					pixel = CRGB(scale8(pixel.r, value.r), scale8(pixel.g, value.g), scale8(pixel.b, value.b));
+					break;
+				case BLEND_MASK:
+					pixel.nscale8(value.getLuma());
+					break;
+			}
+		}
+
 		BasePatternMapper** mappings;
-		const uint8_t num_mappings;
+		const uint8_t num_mappings;					// Number of mappings (or layers)
+		Layer* layers=nullptr;						// Layers to composite (nullptr if mappings write directly to LED array)
+		const uint16_t led_offset=0, num_leds=0;	// Range of LEDs covered by layers
 };
 #endif
\ No newline at end of file
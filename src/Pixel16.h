@@ -0,0 +1,125 @@
+#ifndef Pixel16_h
+#define  Pixel16_h
+#include <FastLED.h>
+
+// Colour with 16 bits per channel, used by the optional high precision rendering pipeline (see LEDuinoController::setHighPrecision())
+// so that slow fades, dim colours and downsampled averages keep their precision until the final quantise to 8 bit LED values
+struct CRGB16 {
+	uint16_t r=0, g=0, b=0;
+
+	CRGB16() {}
+	CRGB16(uint16_t r, uint16_t g, uint16_t b): r(r), g(g), b(b) {}
+	// Exact conversion from 8 bit colour (255 becomes 65535)
+	CRGB16(const CRGB& color): r(color.r*257), g(color.g*257), b(color.b*257) {}
+
+	// Nearest 8 bit colour (without dithering)
+	CRGB toCRGB() const {
+		return CRGB(to8(this->r), to8(this->g), to8(this->b));
+	}
+
+	// Scale all channels by a 16 bit fraction (65535 is approximately unchanged)
+	CRGB16& scale(uint16_t fraction) {
+		this->r = ((uint32_t) this->r*fraction) >> 16;
+		this->g = ((uint32_t) this->g*fraction) >> 16;
+		this->b = ((uint32_t) this->b*fraction) >> 16;
+		return *this;
+	}
+
+	bool operator==(const CRGB16& other) const {
+		return this->r == other.r && this->g == other.g && this->b == other.b;
+	}
+
+	explicit operator bool() const {
+		return this->r || this->g || this->b;
+	}
+
+	static uint8_t to8(uint16_t value) {
+		return (value - (value >> 8) + 128) >> 8;
+	}
+};
+
+// Blend from colour a to colour b by a 16 bit fraction (0 is a, 65535 is approximately b)
+CRGB16 blend16(const CRGB16& a, const CRGB16& b, uint16_t amount) {
+	uint32_t keep = 65536 - amount;
+	return CRGB16(
+		(a.r*keep + (uint32_t) b.r*amount) >> 16,
+		(a.g*keep + (uint32_t) b.g*amount) >> 16,
+		(a.b*keep + (uint32_t) b.b*amount) >> 16
+	);
+}
+
+// Convert 8 bit pixels to 16 bit pixels
+void widen_pixels(const CRGB* pixels, CRGB16* pixels16, uint16_t num_pixels) {
+	for (uint16_t i=0; i < num_pixels; i++) {
+		pixels16[i] = CRGB16(pixels[i]);
+	}
+}
+
+// Convert 16 bit pixels to the nearest 8 bit pixels (exact for pixels converted by widen_pixels())
+void narrow_pixels(const CRGB16* pixels16, CRGB* pixels, uint16_t num_pixels) {
+	for (uint16_t i=0; i < num_pixels; i++) {
+		pixels[i] = pixels16[i].toCRGB();
+	}
+}
+
+// Size in bytes of a 16 bit pixel buffer
+constexpr size_t pixel_buffer16_size(uint16_t num_pixels) { return num_pixels*sizeof(CRGB16); }
+
+// Applies brightness to 16 bit pixels and quantises them to 8 bit LED values in one pass, with ordered temporal dithering.
+// Each pixel adds a threshold from a 4x4 Bayer matrix (indexed by pixel position, and rotated every frame) before
+// the low byte is dropped, so a value between two 8 bit levels alternates between them in proportion to the remainder
+// over 16 frames, and neighbouring pixels are out of phase. The brightness scale maps full value to 255 with space
+// for the largest threshold, so no saturation check is needed in the loop
+class DitherQuantiser {
+	public:
+		// Set brightness applied before quantising (0-255, as FastLED.setBrightness())
+		void setBrightness(uint8_t brightness) {
+			this->brightness = brightness;
+			this->scale = ((uint32_t) brightness*65281)/255;
+		}
+
+		uint8_t getBrightness() const {
+			return this->brightness;
+		}
+
+		// Enable or disable dithering (when disabled, values are rounded to the nearest 8 bit value)
+		void setDither(bool dither) {
+			this->dither = dither;
+		}
+
+		// Scale and quantise pixels16 to leds, and advance dither to the next frame
+		void quantise(const CRGB16* pixels16, CRGB* leds, uint16_t num_pixels) {
+			// Thresholds for this frame, rotated so each pixel uses every threshold over 16 frames (7 is coprime with 16)
+			uint8_t thresholds[16];
+			for (uint8_t i=0; i < 16; i++) {
+				thresholds[i] = this->dither ? bayer_thresholds[(i + this->frame_offset) & 15] : 128;
+			}
+			this->frame_offset += 7;
+			const uint32_t scale = this->scale;
+			for (uint16_t i=0; i < num_pixels; i++) {
+				const CRGB16& pixel = pixels16[i];
+				uint16_t threshold = thresholds[i & 15];
+				// Scaled values are at most 65280, so adding a threshold of up to 255 can't overflow 16 bits
+				leds[i] = CRGB(
+					(((pixel.r*scale + 0x8000) >> 16) + threshold) >> 8,
+					(((pixel.g*scale + 0x8000) >> 16) + threshold) >> 8,
+					(((pixel.b*scale + 0x8000) >> 16) + threshold) >> 8
+				);
+			}
+		}
+
+	protected:
+		// 4x4 Bayer matrix in row-major order, scaled to the centres of 16 steps between 8 bit levels
+		static constexpr uint8_t bayer_thresholds[16] = {
+			8, 136, 40, 168, 200, 72, 232, 104, 56, 184, 24, 152, 248, 120, 216, 88
+		};
+
+		uint8_t brightness=255;
+		uint32_t scale=65281;			// Brightness as a multiplier which maps 65535 to 65280
+		bool dither=true;
+		uint8_t frame_offset=0;			// Rotation of thresholds for current frame
+};
+
+constexpr uint8_t DitherQuantiser::bayer_thresholds[16];
+
+#endif
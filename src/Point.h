@@ -87,6 +87,7 @@ class Point: public Printable {
 		};
 		
 		// Calculate distance of this point from plane defined by a normal vector and point
+		// (use Plane to pre-calculate the plane equation when finding the distance of many points)
 		float distance_to_plane(Point& norm_vector, Point& plane_point)	const {
 			// Calculate coefficent D of plane equation
 			float D = norm_vector.x*plane_point.x + norm_vector.y*plane_point.y + norm_vector.z*plane_point.z;
@@ -103,7 +104,8 @@ class Point: public Printable {
 		
 		// Square of Distance to other point (useful for doing distance comparisons and dont want to square root)
 		float distance_squared(const Point& other)	const {
-			return pow(other.x-this->x, 2) + pow(other.y-this->y, 2) + pow(other.z-this->z, 2); 
+			float dx = other.x-this->x, dy = other.y-this->y, dz = other.z-this->z;
+			return dx*dx + dy*dy + dz*dz;
 		};
 		
 		
@@ -171,9 +173,32 @@ class Bounds {
 		Point min_point, max_point;
 };
 
+// Plane defined by a normal vector and a point on the plane, with the plane equation pre-calculated (normalised)
+// so that the distance of each point from the plane is a dot product and subtraction
+class Plane {
+	public:
+		Plane(const Point& norm_vector, const Point& plane_point) {
+			this->normal = norm_vector/norm_vector.norm();
+			this->D = this->normal.x*plane_point.x + this->normal.y*plane_point.y + this->normal.z*plane_point.z;
+		}
+
+		// Distance of point from plane, positive on the side that the normal vector points to
+		float signed_distance(const Point& point) const {
+			return this->normal.x*point.x + this->normal.y*point.y + this->normal.z*point.z - this->D;
+		}
+
+		// Distance of point from plane
+		float distance(const Point& point) const {
+			return fabs(this->signed_distance(point));
+		}
+
+		Point normal;		// Unit normal vector
+		float D;			// Coefficient D of plane equation (for unit normal)
+};
+
 // Get Bounds of an array of points
 Bounds get_bounds_of_points(Point* points, uint16_t num_points) {
-	Point max_point(FLT_MIN, FLT_MIN, FLT_MIN);
+	Point max_point(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 	Point min_point(FLT_MAX, FLT_MAX, FLT_MAX);
 	for (uint16_t i=0; i < num_points; i++) {
 		Point& point = points[i];
@@ -0,0 +1,210 @@
+#ifndef PointBuffer_h
+#define  PointBuffer_h
+#include <float.h>
+#include "Point.h"
+#include "StripSegment.h"
+#include "Transform.h"
+
+// Tells the compiler that the arrays used by batched point operations do not overlap, so the loops can be vectorised
+// (SSE/AVX/NEON on a host, and without reloading values on Cortex-M). Can be defined as empty for compilers without __restrict__
+#ifndef LEDUINO_RESTRICT
+	#define LEDUINO_RESTRICT __restrict__
+#endif
+
+// Structure-of-arrays storage of points (separate x, y and z arrays), with operations applied to every point in one pass
+// Used to pre-calculate the positions of a whole LED layout, so mappers and patterns can work on all LEDs at once
+// instead of looking up and transforming positions one LED at a time. Loops are written over plain float arrays
+// so that the compiler can vectorise them where the target supports it, and they are simple scalar loops otherwise.
+// Base class uses caller-provided arrays, see PointBuffer for storage of a fixed capacity
+class PointBuffer_T {
+	public:
+		PointBuffer_T(
+			float* x,				// Array of x coordinates (length capacity)
+			float* y,				// Array of y coordinates (length capacity)
+			float* z,				// Array of z coordinates (length capacity)
+			uint16_t capacity		// Maximum number of points
+		): x(x), y(y), z(z), capacity(capacity) {}
+
+		// Number of points in buffer
+		uint16_t size() const {
+			return this->num_points;
+		}
+
+		// Set number of points in buffer (limited to capacity)
+		void resize(uint16_t num_points) {
+			this->num_points = limit(num_points, this->capacity);
+		}
+
+		Point get(uint16_t i) const {
+			return Point(this->x[i], this->y[i], this->z[i]);
+		}
+
+		void set(uint16_t i, const Point& point) {
+			this->x[i] = point.x;
+			this->y[i] = point.y;
+			this->z[i] = point.z;
+		}
+
+		// Load positions of every LED of the spatial segments (in segment order). Returns false if capacity is too small
+		bool loadSegments(SpatialStripSegment_T** spatial_segments, uint8_t num_segments) {
+			uint16_t i = 0;
+			for (uint8_t segment_id=0; segment_id < num_segments; segment_id++) {
+				SpatialStripSegment_T* spatial_segment = spatial_segments[segment_id];
+				for (uint16_t segment_pos=0; segment_pos < spatial_segment->strip_segment.segment_len; segment_pos++, i++) {
+					if (i >= this->capacity) {
+						this->num_points = this->capacity;
+						return false;
+					}
+					this->set(i, spatial_segment->getSpatialPosition(segment_pos));
+				}
+			}
+			this->num_points = i;
+			return true;
+		}
+
+		// Subtract offset from every point and scale each axis (same result as (point - offset).hadamard_product(scale_factors))
+		void offsetScale(const Point& offset, const Point& scale_factors) {
+			offset_scale(this->x, this->num_points, offset.x, scale_factors.x);
+			offset_scale(this->y, this->num_points, offset.y, scale_factors.y);
+			offset_scale(this->z, this->num_points, offset.z, scale_factors.z);
+		}
+
+		// Apply affine transformation to every point
+		void transform(const AffineTransform& transform) {
+			float* LEDUINO_RESTRICT x = this->x;
+			float* LEDUINO_RESTRICT y = this->y;
+			float* LEDUINO_RESTRICT z = this->z;
+			const float (*m)[3] = transform.m;
+			const Point& t = transform.translation;
+			for (uint16_t i=0; i < this->num_points; i++) {
+				float px = x[i], py = y[i], pz = z[i];
+				x[i] = m[0][0]*px + m[0][1]*py + m[0][2]*pz + t.x;
+				y[i] = m[1][0]*px + m[1][1]*py + m[1][2]*pz + t.y;
+				z[i] = m[2][0]*px + m[2][1]*py + m[2][2]*pz + t.z;
+			}
+		}
+
+		// Apply affine transformation to every point, storing the results in another buffer (with at least the same capacity)
+		void transform(const AffineTransform& transform, PointBuffer_T& out) const {
+			const float* LEDUINO_RESTRICT x = this->x;
+			const float* LEDUINO_RESTRICT y = this->y;
+			const float* LEDUINO_RESTRICT z = this->z;
+			float* LEDUINO_RESTRICT out_x = out.x;
+			float* LEDUINO_RESTRICT out_y = out.y;
+			float* LEDUINO_RESTRICT out_z = out.z;
+			const float (*m)[3] = transform.m;
+			const Point& t = transform.translation;
+			out.resize(this->num_points);
+			for (uint16_t i=0; i < out.num_points; i++) {
+				out_x[i] = m[0][0]*x[i] + m[0][1]*y[i] + m[0][2]*z[i] + t.x;
+				out_y[i] = m[1][0]*x[i] + m[1][1]*y[i] + m[1][2]*z[i] + t.y;
+				out_z[i] = m[2][0]*x[i] + m[2][1]*y[i] + m[2][2]*z[i] + t.z;
+			}
+		}
+
+		// Dot product of every point with a vector (out must have length of at least size())
+		void dot(const Point& vector, float* LEDUINO_RESTRICT out) const {
+			const float* LEDUINO_RESTRICT x = this->x;
+			const float* LEDUINO_RESTRICT y = this->y;
+			const float* LEDUINO_RESTRICT z = this->z;
+			for (uint16_t i=0; i < this->num_points; i++) {
+				out[i] = vector.x*x[i] + vector.y*y[i] + vector.z*z[i];
+			}
+		}
+
+		// Signed distance of every point from a plane (positive on the side that the plane normal points to)
+		void planeDistance(const Plane& plane, float* LEDUINO_RESTRICT out) const {
+			this->dot(plane.normal, out);
+			for (uint16_t i=0; i < this->num_points; i++) {
+				out[i] -= plane.D;
+			}
+		}
+
+		// Squared euclidean norm of every point (distance squared from origin)
+		void normSquared(float* LEDUINO_RESTRICT out) const {
+			const float* LEDUINO_RESTRICT x = this->x;
+			const float* LEDUINO_RESTRICT y = this->y;
+			const float* LEDUINO_RESTRICT z = this->z;
+			for (uint16_t i=0; i < this->num_points; i++) {
+				out[i] = x[i]*x[i] + y[i]*y[i] + z[i]*z[i];
+			}
+		}
+
+		// Euclidean norm of every point (distance from origin)
+		void norm(float* LEDUINO_RESTRICT out) const {
+			this->normSquared(out);
+			for (uint16_t i=0; i < this->num_points; i++) {
+				out[i] = sqrtf(out[i]);
+			}
+		}
+
+		// Bounding box of all points
+		Bounds bounds() const {
+			Point min_point(FLT_MAX, FLT_MAX, FLT_MAX);
+			Point max_point(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			axis_range(this->x, this->num_points, min_point.x, max_point.x);
+			axis_range(this->y, this->num_points, min_point.y, max_point.y);
+			axis_range(this->z, this->num_points, min_point.z, max_point.z);
+			return Bounds(min_point, max_point);
+		}
+
+		// Index of the point closest to 'point' (size() if buffer is empty). Optionally returns the squared distance to it
+		uint16_t nearest(const Point& point, float* distance_squared=nullptr) const {
+			uint16_t nearest_index = this->num_points;
+			float nearest_distance = FLT_MAX;
+			for (uint16_t i=0; i < this->num_points; i++) {
+				float dx = this->x[i] - point.x, dy = this->y[i] - point.y, dz = this->z[i] - point.z;
+				float d = dx*dx + dy*dy + dz*dz;
+				if (d < nearest_distance) {
+					nearest_distance = d;
+					nearest_index = i;
+				}
+			}
+			if (distance_squared != nullptr) {
+				*distance_squared = nearest_distance;
+			}
+			return nearest_index;
+		}
+
+		// RAM used by buffer, including coordinate arrays
+		size_t memoryUsage() const {
+			return sizeof(PointBuffer_T) + 3*this->capacity*sizeof(float);
+		}
+
+	protected:
+		static void offset_scale(float* LEDUINO_RESTRICT values, uint16_t length, float offset, float scale) {
+			for (uint16_t i=0; i < length; i++) {
+				values[i] = (values[i] - offset)*scale;
+			}
+		}
+
+		static void axis_range(const float* LEDUINO_RESTRICT values, uint16_t length, float& min_value, float& max_value) {
+			for (uint16_t i=0; i < length; i++) {
+				if (values[i] < min_value) min_value = values[i];
+				if (values[i] > max_value) max_value = values[i];
+			}
+		}
+
+		float* x;
+		float* y;
+		float* z;
+		const uint16_t capacity;
+		uint16_t num_points=0;
+};
+
+// PointBuffer with storage for a fixed number of points
+template<uint16_t t_capacity>
+class PointBuffer : public PointBuffer_T {
+	public:
+		PointBuffer(): PointBuffer_T(this->x_data, this->y_data, this->z_data, t_capacity) {}
+		// Coordinate arrays belong to this buffer, so it can't be copied
+		PointBuffer(const PointBuffer&) = delete;
+		PointBuffer& operator=(const PointBuffer&) = delete;
+
+	protected:
+		float x_data[t_capacity];
+		float y_data[t_capacity];
+		float z_data[t_capacity];
+};
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef PowerMeter_h
+#define  PowerMeter_h
+#include <FastLED.h>
+#include "Pixel16.h"
+
+// Sums of each colour channel over a set of LEDs (in 8 bit units), and the number of LEDs summed
+struct ChannelSums {
+	uint32_t r=0, g=0, b=0;
+	uint16_t num_leds=0;
+
+	void add(const CRGB& value) {
+		this->r += value.r;
+		this->g += value.g;
+		this->b += value.b;
+		this->num_leds++;
+	}
+
+	void add(const CRGB16& value) {
+		this->r += value.r >> 8;
+		this->g += value.g >> 8;
+		this->b += value.b >> 8;
+		this->num_leds++;
+	}
+
+	void clear() {
+		this->r = this->g = this->b = 0;
+		this->num_leds = 0;
+	}
+};
+
+// Current drawn by each colour channel of an LED at full value, and by an LED which is off (in mA)
+// Defaults are for WS2812B LEDs at 5V (the same model as FastLED's power limiter)
+struct PowerModel {
+	uint8_t red=16, green=11, blue=15, idle=1;
+
+	// Current drawn by the colour channels of LEDs with the given sums at full brightness (not including idle current)
+	uint32_t channelCurrent(const ChannelSums& sums) const {
+		return (sums.r*this->red + sums.g*this->green + sums.b*this->blue)/255;
+	}
+};
+
+// A range of LEDs powered by its own supply, with an optional current limit
+struct PowerOutput {
+	uint16_t start_led=0;		// Index of first LED in LED array
+	uint16_t num_leds=0;		// Number of LEDs
+	uint32_t max_current=0;		// Current limit of supply in mA (0 for no limit)
+	ChannelSums sums;			// Sums of the current frame
+};
+
+// Estimates the current drawn by each frame, and the highest brightness which keeps it within the configured limits
+// (see LEDuinoController::setPowerMeter()). Mappers which support it add LEDs to the meter as they write them (see
+// BasePatternMapper::setPowerMeter()), so no extra pass over the LED array is needed, otherwise the controller measures
+// the LED array after rendering. Breakdowns are kept for each strip segment of the current mapping and for each output,
+// where outputs are ranges of the LED array with their own supplies and limits. LEDs in overlapping segments are added
+// once for each segment, in the total and output sums as well as the segment breakdown, so mappings with overlapping
+// segments over-estimate the current and limit brightness more than needed.
+// Base class uses caller-provided arrays, see PowerMeter for storage of a fixed size
+class PowerMeter_T {
+	public:
+		PowerMeter_T(
+			ChannelSums* segment_sums,		// Array of sums for each segment (length max_segments)
+			uint8_t max_segments,			// Number of segments to keep a breakdown for (segments with higher IDs are only included in the total)
+			PowerOutput* outputs,			// Array of outputs (length max_outputs)
+			uint8_t max_outputs				// Maximum number of outputs
+		):
+		segment_sums(segment_sums),
+		max_segments(max_segments),
+		outputs(outputs),
+		max_outputs(max_outputs) {}
+
+		// Set current limit of all LEDs in mA (0 for no limit)
+		void setLimit(uint32_t max_current) {
+			this->max_current = max_current;
+		}
+
+		// Set current drawn by each LED channel
+		void setModel(const PowerModel& model) {
+			this->model = model;
+		}
+
+		// Add range of LEDs which is powered by its own supply, with its own current limit in mA (0 for no limit)
+		// Returns false if there are already max_outputs outputs
+		bool addOutput(uint16_t start_led, uint16_t num_leds, uint32_t max_current=0) {
+			if (this->num_outputs >= this->max_outputs) {
+				return false;
+			}
+			PowerOutput& output = this->outputs[this->num_outputs++];
+			output.start_led = start_led;
+			output.num_leds = num_leds;
+			output.max_current = max_current;
+			output.sums.clear();
+			return true;
+		}
+
+		// Set number of LEDs in LED array (set by LEDuinoController)
+		void setNumLEDs(uint16_t num_leds) {
+			this->num_leds = num_leds;
+		}
+
+		// Clear sums before rendering a frame
+		void beginFrame() {
+			this->total.clear();
+			for (uint8_t i=0; i < this->max_segments; i++) {
+				this->segment_sums[i].clear();
+			}
+			for (uint8_t i=0; i < this->num_outputs; i++) {
+				this->outputs[i].sums.clear();
+			}
+			this->measured = false;
+			this->segments_measured = false;
+		}
+
+		// Called by mappers before adding the LEDs they write for the frame
+		void beginMapping() {
+			this->measured = true;
+			this->segments_measured = true;
+		}
+
+		// Add value of an LED written by a mapper
+		template<typename PixelT>
+		void add(uint8_t segment_id, uint16_t led_id, const PixelT& value) {
+			this->total.add(value);
+			if (segment_id < this->max_segments) {
+				this->segment_sums[segment_id].add(value);
+			}
+			if (this->num_outputs > 0) {
+				this->addToOutput(led_id, value);
+			}
+		}
+
+		// Whether LEDs were added by the mapper for the current frame
+		bool isMeasured() const {
+			return this->measured;
+		}
+
+		// Measure the whole LED array, when the mapper did not add LEDs (no segment breakdown is available)
+		template<typename PixelT>
+		void measure(const PixelT* leds, uint16_t num_leds) {
+			for (uint16_t i=0; i < num_leds; i++) {
+				this->total.add(leds[i]);
+				if (this->num_outputs > 0) {
+					this->addToOutput(i, leds[i]);
+				}
+			}
+			this->measured = true;
+		}
+
+		// Highest brightness up to 'brightness' which keeps the estimated current of all LEDs and each output within their limits
+		// The result is recorded as the brightness of the frame
+		uint8_t limitBrightness(uint8_t brightness) {
+			brightness = limit_brightness(this->model.channelCurrent(this->total), (uint32_t) this->num_leds*this->model.idle, this->max_current, brightness);
+			for (uint8_t i=0; i < this->num_outputs; i++) {
+				const PowerOutput& output = this->outputs[i];
+				brightness = limit_brightness(this->model.channelCurrent(output.sums), (uint32_t) output.num_leds*this->model.idle, output.max_current, brightness);
+			}
+			this->brightness = brightness;
+			return brightness;
+		}
+
+		// Brightness of the last frame (after limiting)
+		uint8_t getBrightness() const {
+			return this->brightness;
+		}
+
+		// Estimated current of all LEDs for the last frame in mA
+		uint32_t totalCurrent() const {
+			return this->current(this->total, this->num_leds);
+		}
+
+		// Estimated current of a segment of the current mapping for the last frame in mA (0 if not measured)
+		uint32_t segmentCurrent(uint8_t segment_id) const {
+			if (segment_id >= this->max_segments || !this->segments_measured) {
+				return 0;
+			}
+			const ChannelSums& sums = this->segment_sums[segment_id];
+			return this->current(sums, sums.num_leds);
+		}
+
+		// Estimated current of an output for the last frame in mA
+		uint32_t outputCurrent(uint8_t output_id) const {
+			if (output_id >= this->num_outputs) {
+				return 0;
+			}
+			const PowerOutput& output = this->outputs[output_id];
+			return this->current(output.sums, output.num_leds);
+		}
+
+		// Whether the last frame has a breakdown for each segment (only when LEDs were added by the mapper)
+		bool hasSegmentBreakdown() const {
+			return this->segments_measured;
+		}
+
+		uint8_t numOutputs() const {
+			return this->num_outputs;
+		}
+
+		// Print estimated current of the last frame, and of each output (e.g. to Serial)
+		void print(Print& out) const {
+			out.print("Current (mA): "); out.println((unsigned long) this->totalCurrent());
+			for (uint8_t i=0; i < this->num_outputs; i++) {
+				out.print("Output "); out.print(i); out.print(": "); out.println((unsigned long) this->outputCurrent(i));
+			}
+			out.print("Brightness: "); out.println(this->brightness);
+		}
+
+		// RAM used by meter (including its arrays)
+		size_t memoryUsage() const {
+			return sizeof(*this) + this->max_segments*sizeof(ChannelSums) + this->max_outputs*sizeof(PowerOutput);
+		}
+
+	protected:
+		// Estimated current at the brightness of the last frame in mA
+		uint32_t current(const ChannelSums& sums, uint16_t num_leds) const {
+			return (this->model.channelCurrent(sums)*this->brightness)/255 + (uint32_t) num_leds*this->model.idle;
+		}
+
+		// Highest brightness up to 'brightness' which keeps channel_current (at full brightness) plus idle_current within max_current
+		static uint8_t limit_brightness(uint32_t channel_current, uint32_t idle_current, uint32_t max_current, uint8_t brightness) {
+			if (max_current == 0 || (channel_current*brightness)/255 + idle_current <= max_current) {
+				return brightness;
+			}
+			if (idle_current >= max_current) {
+				return 0;
+			}
+			return ((max_current - idle_current)*255)/channel_current;
+		}
+
+		// Add LED to the output containing it (the last output used is checked first, as LEDs are mostly written in runs)
+		template<typename PixelT>
+		void addToOutput(uint16_t led_id, const PixelT& value) {
+			PowerOutput* output = &this->outputs[this->last_output];
+			if ((uint16_t) (led_id - output->start_led) >= output->num_leds) {
+				uint8_t i = 0;
+				for (; i < this->num_outputs; i++) {
+					output = &this->outputs[i];
+					if ((uint16_t) (led_id - output->start_led) < output->num_leds) {
+						break;
+					}
+				}
+				if (i == this->num_outputs) {
+					return;
+				}
+				this->last_output = i;
+			}
+			output->sums.add(value);
+		}
+
+		ChannelSums* segment_sums;
+		const uint8_t max_segments;
+		PowerOutput* outputs;
+		const uint8_t max_outputs;
+		uint8_t num_outputs=0;
+		uint8_t last_output=0;			// Output containing the last LED added
+		PowerModel model;
+		uint32_t max_current=0;			// Limit of all LEDs in mA (0 for no limit)
+		uint16_t num_leds=0;
+		ChannelSums total;				// Sums of all LEDs for the current frame
+		uint8_t brightness=255;			// Brightness of the last frame
+		bool measured=false;			// Whether LEDs have been added for the current frame
+		bool segments_measured=false;	// Whether LEDs were added by the mapper (with segment IDs)
+};
+
+// PowerMeter with storage for a breakdown of up to t_segments segments and t_outputs outputs
+template<uint8_t t_segments, uint8_t t_outputs=1>
+class PowerMeter : public PowerMeter_T {
+	public:
+		PowerMeter(): PowerMeter_T(this->segment_data, t_segments, this->output_data, t_outputs) {}
+		// Arrays belong to this meter, so it can't be copied
+		PowerMeter(const PowerMeter&) = delete;
+		PowerMeter& operator=(const PowerMeter&) = delete;
+
+	protected:
+		ChannelSums segment_data[t_segments > 0 ? t_segments : 1];
+		PowerOutput output_data[t_outputs > 0 ? t_outputs : 1];
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef Scheduler_h
+#define  Scheduler_h
+#include "utils.h"
+#if defined(__unix__) || defined(__APPLE__)
+	#include <time.h>
+#elif defined(__AVR__)
+	#include <avr/sleep.h>
+#endif
+
+// Can override maximum number of background tasks by setting before including LEDuino
+#ifndef LEDUINO_MAX_BACKGROUND_TASKS
+	#define LEDUINO_MAX_BACKGROUND_TASKS 4
+#endif
+// Time before a frame is due that background tasks must finish and sleep must end (in ms)
+#ifndef LEDUINO_SLACK_MARGIN
+	#define LEDUINO_SLACK_MARGIN 1
+#endif
+
+// Low priority work run in the slack time between frames (e.g. precomputing tables, flushing telemetry or filling caches)
+// Should do a small amount of work and return within 'budget' us. Returns true if it has more work to do, or false if it is idle
+typedef bool (*BackgroundTask)(uint32_t budget);
+
+// Sleep the processor for up to max_time ms (may wake early)
+// On a host this sleeps the thread, on ARM it waits for the next interrupt (at least the millisecond tick),
+// on AVR it enters idle sleep until the next interrupt, and on ESP32 it yields to the FreeRTOS idle task
+void idle_sleep(uint16_t max_time) {
+	if (max_time == 0) {
+		return;
+	}
+	#if defined(__unix__) || defined(__APPLE__)
+		struct timespec sleep_time = {max_time/1000, (max_time%1000)*1000000L};
+		nanosleep(&sleep_time, nullptr);
+	#elif defined(ESP32)
+		delay(max_time);
+	#elif defined(__arm__)
+		asm volatile("wfi");
+	#elif defined(__AVR__)
+		set_sleep_mode(SLEEP_MODE_IDLE);
+		sleep_mode();
+	#endif
+}
+
+// Cooperative scheduler for BackgroundTasks, run in the time until the next frame is due
+// Tasks are run in turn (continuing from the last task run) until the slack time is used or every task is idle,
+// then the processor can sleep for the rest of the slack time instead of polling the clock
+class SlackScheduler {
+	public:
+		// Register a task. Returns false if LEDUINO_MAX_BACKGROUND_TASKS tasks are already registered
+		bool addTask(BackgroundTask task) {
+			if (this->num_tasks >= LEDUINO_MAX_BACKGROUND_TASKS) {
+				return false;
+			}
+			this->tasks[this->num_tasks++] = task;
+			return true;
+		}
+
+		// Whether any tasks are registered
+		bool hasTasks() const {
+			return this->num_tasks > 0;
+		}
+
+		// Run tasks for up to 'slack' ms (less LEDUINO_SLACK_MARGIN), then sleep for the remaining time if 'sleep' is set
+		void run(uint16_t slack, bool sleep) {
+			if (slack <= LEDUINO_SLACK_MARGIN) {
+				return;
+			}
+			uint32_t start_time = micros();
+			uint32_t budget = (uint32_t) (slack - LEDUINO_SLACK_MARGIN)*1000;
+			uint8_t idle_tasks = 0;
+			while (idle_tasks < this->num_tasks) {
+				uint32_t elapsed = micros() - start_time;
+				if (elapsed >= budget) {
+					return;
+				}
+				BackgroundTask task = this->tasks[this->next_task];
+				this->next_task = (this->next_task + 1) % this->num_tasks;
+				idle_tasks = task(budget - elapsed) ? 0 : idle_tasks + 1;
+			}
+			if (sleep) {
+				uint32_t elapsed = micros() - start_time;
+				if (elapsed < budget) {
+					idle_sleep((budget - elapsed)/1000);
+				}
+			}
+		}
+
+	protected:
+		BackgroundTask tasks[LEDUINO_MAX_BACKGROUND_TASKS];
+		uint8_t num_tasks=0;
+		uint8_t next_task=0;		// Index of task to run first in next slack period
+};
+
+#endif
@@ -0,0 +1,334 @@
+#ifndef SharedMemoryOutput_h
+#define  SharedMemoryOutput_h
+#include <FastLED.h>
+#include <math.h>
+#include "StripSegment.h"
+// Shared memory output for host builds (Linux/macOS), so a separate visualiser process can display the LEDs
+// Not included by LEDuino.h, include after LEDuino.h on a host build
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LEDUINO_SHARED_MAGIC 0x5544454C		// "LEDU" in little-endian byte order
+#define LEDUINO_SHARED_VERSION 1
+
+// Layout of the shared memory region (all offsets in bytes from the start of the region):
+//   SharedLayoutHeader
+//   LED positions at positions_offset: x, y, z floats for each LED in LED array order (NaN for LEDs without a position)
+//   num_slots frame slots at frames_offset, each slot_size bytes: SharedFrameSlot followed by num_leds RGB values
+// Frames are written to slots in turn, so a reader can use the latest frame in place (without copying it) while the next
+// frames are written to other slots. The sequence number of a slot is 0 while it is being written, so a reader can check that
+// the frame it used was not overwritten by comparing the slot sequence number afterwards (see SharedFrameReader)
+struct SharedLayoutHeader {
+	uint32_t magic;					// LEDUINO_SHARED_MAGIC
+	uint16_t version;				// LEDUINO_SHARED_VERSION
+	uint16_t num_leds;				// Number of LEDs in each frame
+	uint16_t num_slots;				// Number of frame slots in ring buffer
+	uint16_t layout_valid;			// 1 when LED positions have been exported
+	uint32_t positions_offset;		// Offset of LED positions
+	uint32_t frames_offset;			// Offset of first frame slot
+	uint32_t slot_size;				// Size of each frame slot
+	uint32_t sequence;				// Number of frames published (the latest frame is in slot (sequence - 1) % num_slots)
+};
+
+// Header of each frame slot
+struct SharedFrameSlot {
+	uint32_t sequence;				// Sequence number of frame in slot (0 while it is being written)
+	uint32_t timestamp;				// Time the frame was published (micros())
+};
+
+// Writes LED frames into a named POSIX shared memory ring buffer (see SharedLayoutHeader), with the LED layout exported once
+// Frames can be published from an LED array with publish(), or written in place with beginFrame() and endFrame()
+// (see SharedMemoryLEDController to publish every FastLED.show())
+class SharedFrameBuffer {
+	public:
+		SharedFrameBuffer(
+			const char* name="/leduino",	// Name of shared memory object (starting with '/')
+			uint8_t num_slots=4				// Number of frames in ring buffer (at least 2)
+		):
+		name(name),
+		num_slots(num_slots < 2 ? 2 : num_slots) {}
+
+		~SharedFrameBuffer() {
+			this->close();
+		}
+
+		// SharedFrameBuffer owns the shared memory mapping, so it can't be copied
+		SharedFrameBuffer(const SharedFrameBuffer&) = delete;
+		SharedFrameBuffer& operator=(const SharedFrameBuffer&) = delete;
+
+		// Create (or replace) shared memory object for num_leds LEDs, and map it. Returns false if it could not be created
+		bool open(uint16_t num_leds) {
+			this->close();
+			uint32_t positions_size = (uint32_t) num_leds*3*sizeof(float);
+			uint32_t slot_size = (sizeof(SharedFrameSlot) + num_leds*sizeof(CRGB) + 3) & ~3UL;
+			uint32_t frames_offset = sizeof(SharedLayoutHeader) + positions_size;
+			this->size = frames_offset + slot_size*this->num_slots;
+
+			int fd = shm_open(this->name, O_CREAT | O_RDWR, 0644);
+			if (fd < 0) {
+				return false;
+			}
+			if (ftruncate(fd, this->size) != 0) {
+				::close(fd);
+				return false;
+			}
+			void* memory = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			// Mapping stays valid after the file descriptor is closed
+			::close(fd);
+			if (memory == MAP_FAILED) {
+				return false;
+			}
+			this->memory = (uint8_t*) memory;
+			this->header = (SharedLayoutHeader*) memory;
+			// Magic is cleared before the header is written, so a reader opening the object meanwhile (or a previous object with the
+			// same name) doesn't use a partly written header. Sequence numbers are also cleared, so the old frames aren't seen as valid
+			__atomic_store_n(&this->header->magic, 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&this->header->sequence, 0, __ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+			this->header->num_leds = num_leds;
+			this->header->num_slots = this->num_slots;
+			this->header->layout_valid = 0;
+			this->header->positions_offset = sizeof(SharedLayoutHeader);
+			this->header->frames_offset = frames_offset;
+			this->header->slot_size = slot_size;
+			float* positions = this->positions();
+			for (uint32_t i=0; i < (uint32_t) num_leds*3; i++) {
+				positions[i] = NAN;
+			}
+			for (uint8_t slot=0; slot < this->num_slots; slot++) {
+				this->slot(slot)->sequence = 0;
+			}
+			this->header->version = LEDUINO_SHARED_VERSION;
+			__atomic_store_n(&this->header->magic, LEDUINO_SHARED_MAGIC, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		// Unmap and remove shared memory object (readers which have it mapped can still read the last frames)
+		void close() {
+			if (this->memory != nullptr) {
+				munmap(this->memory, this->size);
+				shm_unlink(this->name);
+				this->memory = nullptr;
+				this->header = nullptr;
+			}
+		}
+
+		bool isOpen() const {
+			return this->memory != nullptr;
+		}
+
+		// Export positions of the LEDs of spatial segments (only needs to be done once, after open())
+		void exportLayout(SpatialStripSegment_T** spatial_segments, uint8_t num_segments) {
+			if (this->header == nullptr) {
+				return;
+			}
+			float* positions = this->positions();
+			for (uint8_t segment_id=0; segment_id < num_segments; segment_id++) {
+				SpatialStripSegment_T* spatial_segment = spatial_segments[segment_id];
+				for (uint16_t segment_pos=0; segment_pos < spatial_segment->strip_segment.segment_len; segment_pos++) {
+					uint16_t led_id = spatial_segment->strip_segment.getLEDId(segment_pos);
+					if (led_id >= this->header->num_leds) {
+						continue;
+					}
+					Point position = spatial_segment->getSpatialPosition(segment_pos);
+					positions[led_id*3] = position.x;
+					positions[led_id*3 + 1] = position.y;
+					positions[led_id*3 + 2] = position.z;
+				}
+			}
+			__atomic_store_n(&this->header->layout_valid, 1, __ATOMIC_RELEASE);
+		}
+
+		// Start writing the next frame, and return its LED array in shared memory (num_leds long, nullptr if not open)
+		CRGB* beginFrame() {
+			if (this->header == nullptr) {
+				return nullptr;
+			}
+			SharedFrameSlot* slot = this->slot(this->header->sequence % this->num_slots);
+			// Mark slot as being written before any LED values are changed
+			__atomic_store_n(&slot->sequence, 0, __ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+			return (CRGB*) (slot + 1);
+		}
+
+		// Finish writing the frame started by beginFrame(), and make it the latest frame
+		void endFrame() {
+			uint32_t sequence = this->header->sequence + 1;
+			SharedFrameSlot* slot = this->slot(this->header->sequence % this->num_slots);
+			slot->timestamp = micros();
+			__atomic_store_n(&slot->sequence, sequence, __ATOMIC_RELEASE);
+			__atomic_store_n(&this->header->sequence, sequence, __ATOMIC_RELEASE);
+		}
+
+		// Copy LED array into the next frame and publish it
+		void publish(const CRGB* leds) {
+			CRGB* frame = this->beginFrame();
+			if (frame == nullptr) {
+				return;
+			}
+			memcpy(frame, leds, this->header->num_leds*sizeof(CRGB));
+			this->endFrame();
+		}
+
+		uint16_t numLEDs() const {
+			return this->header == nullptr ? 0 : this->header->num_leds;
+		}
+
+	protected:
+		float* positions() const {
+			return (float*) (this->memory + this->header->positions_offset);
+		}
+
+		SharedFrameSlot* slot(uint8_t slot) const {
+			return (SharedFrameSlot*) (this->memory + this->header->frames_offset + slot*this->header->slot_size);
+		}
+
+		const char* name;
+		const uint8_t num_slots;
+		uint8_t* memory=nullptr;				// Start of shared memory mapping
+		SharedLayoutHeader* header=nullptr;
+		size_t size=0;							// Size of shared memory mapping
+};
+
+// Reads frames from a SharedFrameBuffer in another process (e.g. a visualiser), without copying them
+class SharedFrameReader {
+	public:
+		SharedFrameReader(const char* name="/leduino"): name(name) {}
+
+		~SharedFrameReader() {
+			this->close();
+		}
+
+		SharedFrameReader(const SharedFrameReader&) = delete;
+		SharedFrameReader& operator=(const SharedFrameReader&) = delete;
+
+		// Map shared memory object read-only. Returns false if it does not exist, has not been initialised by the writer, or is too
+		// small for the LED positions and frame slots described by its header
+		bool open() {
+			this->close();
+			int fd = shm_open(this->name, O_RDONLY, 0);
+			if (fd < 0) {
+				return false;
+			}
+			struct stat info;
+			void* memory = MAP_FAILED;
+			if (fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(SharedLayoutHeader)) {
+				memory = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			}
+			::close(fd);
+			if (memory == MAP_FAILED) {
+				return false;
+			}
+			this->memory = (const uint8_t*) memory;
+			this->size = info.st_size;
+			this->header = (const SharedLayoutHeader*) memory;
+			if (__atomic_load_n(&this->header->magic, __ATOMIC_ACQUIRE) != LEDUINO_SHARED_MAGIC || this->header->version != LEDUINO_SHARED_VERSION) {
+				this->close();
+				return false;
+			}
+			// Check the header against the size of the object before any positions or frames are read from it
+			const SharedLayoutHeader* header = this->header;
+			uint64_t positions_end = (uint64_t) header->positions_offset + (uint64_t) header->num_leds*3*sizeof(float);
+			uint64_t frames_end = (uint64_t) header->frames_offset + (uint64_t) header->slot_size*header->num_slots;
+			if (header->num_slots == 0 || header->slot_size < sizeof(SharedFrameSlot) + header->num_leds*sizeof(CRGB)
+				|| positions_end > this->size || frames_end > this->size) {
+				this->close();
+				return false;
+			}
+			return true;
+		}
+
+		void close() {
+			if (this->memory != nullptr) {
+				munmap((void*) this->memory, this->size);
+				this->memory = nullptr;
+				this->header = nullptr;
+			}
+		}
+
+		uint16_t numLEDs() const {
+			return this->header->num_leds;
+		}
+
+		// Positions of LEDs (x, y, z for each LED, NaN for LEDs without a position), or nullptr if not exported yet
+		const float* positions() const {
+			if (!__atomic_load_n(&this->header->layout_valid, __ATOMIC_ACQUIRE)) {
+				return nullptr;
+			}
+			return (const float*) (this->memory + this->header->positions_offset);
+		}
+
+		// Get latest frame. Returns its sequence number (0 if no frame has been published) and sets leds to its LED array
+		// in shared memory. The frame can be overwritten while it is being used, so check it with valid() afterwards
+		uint32_t latest(const CRGB*& leds, uint32_t* timestamp=nullptr) const {
+			while (true) {
+				uint32_t sequence = __atomic_load_n(&this->header->sequence, __ATOMIC_ACQUIRE);
+				if (sequence == 0) {
+					return 0;
+				}
+				const SharedFrameSlot* slot = this->slot(sequence);
+				if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) == sequence) {
+					leds = (const CRGB*) (slot + 1);
+					if (timestamp != nullptr) {
+						*timestamp = slot->timestamp;
+					}
+					return sequence;
+				}
+				// Writer has moved on to this slot again, try the newer frame
+			}
+		}
+
+		// Whether the frame with this sequence number has not been overwritten since it was returned by latest()
+		bool valid(uint32_t sequence) const {
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			return __atomic_load_n(&this->slot(sequence)->sequence, __ATOMIC_RELAXED) == sequence;
+		}
+
+	protected:
+		// Slot containing frame with sequence number
+		const SharedFrameSlot* slot(uint32_t sequence) const {
+			uint16_t slot = (sequence - 1) % this->header->num_slots;
+			return (const SharedFrameSlot*) (this->memory + this->header->frames_offset + slot*this->header->slot_size);
+		}
+
+		const char* name;
+		const uint8_t* memory=nullptr;
+		const SharedLayoutHeader* header=nullptr;
+		size_t size=0;
+};
+
+// FastLED output driver which publishes every FastLED.show() to a SharedFrameBuffer, with FastLED brightness,
+// colour correction and dithering applied as for a real LED strip. Register with FastLED.addLeds(&controller, leds, num_leds)
+class SharedMemoryLEDController : public CPixelLEDController<RGB> {
+	public:
+		SharedMemoryLEDController(SharedFrameBuffer& frame_buffer): frame_buffer(frame_buffer) {}
+
+		void init() override {}
+
+	protected:
+		void showPixels(PixelController<RGB>& pixels) override {
+			CRGB* frame = this->frame_buffer.beginFrame();
+			if (frame == nullptr) {
+				return;
+			}
+			uint16_t num_leds = this->frame_buffer.numLEDs();
+			uint16_t i = 0;
+			while (pixels.has(1) && i < num_leds) {
+				frame[i].r = pixels.loadAndScale0();
+				frame[i].g = pixels.loadAndScale1();
+				frame[i].b = pixels.loadAndScale2();
+				pixels.advanceData();
+				pixels.stepDithering();
+				i++;
+			}
+			this->frame_buffer.endFrame();
+		}
+
+		SharedFrameBuffer& frame_buffer;
+};
+
+#endif
+#endif
@@ -0,0 +1,163 @@
+#ifndef Simulator_h
+#define  Simulator_h
+#include <FastLED.h>
+#include "MappingRunner.h"
+
+// Simulated clock time (in ms), advanced manually instead of following the wall clock
+uint32_t simulated_time = 0;
+
+// TimeSource which returns the simulated clock time
+uint32_t simulated_millis() {
+	return simulated_time;
+}
+
+// FastLED beatX() functions read the time directly, so can be redirected to the simulated clock by defining
+// USE_GET_MILLISECOND_TIMER before including FastLED (FastLED then calls get_millisecond_timer() instead of millis())
+#ifdef USE_GET_MILLISECOND_TIMER
+uint32_t get_millisecond_timer() {
+	return simulated_time;
+}
+#endif
+
+// Hash of LED array contents (32-bit FNV-1a), can be chained by providing hash of previous data
+uint32_t hash_leds(const CRGB* leds, uint16_t num_leds, uint32_t hash=2166136261UL) {
+	for (uint16_t i=0; i < num_leds; i++) {
+		for (uint8_t c=0; c < 3; c++) {
+			hash ^= leds[i].raw[c];
+			hash *= 16777619UL;
+		}
+	}
+	return hash;
+}
+
+// Get maximum difference of any colour channel between two LED arrays (0 if identical)
+// Used to check that a change to a pattern or mapper produces output within a bounded error of a reference frame
+uint8_t max_frame_error(const CRGB* leds, const CRGB* reference, uint16_t num_leds) {
+	uint8_t max_error = 0;
+	for (uint16_t i=0; i < num_leds; i++) {
+		for (uint8_t c=0; c < 3; c++) {
+			uint8_t error = leds[i].raw[c] > reference[i].raw[c] ? leds[i].raw[c] - reference[i].raw[c] : reference[i].raw[c] - leds[i].raw[c];
+			if (error > max_error) max_error = error;
+		}
+	}
+	return max_error;
+}
+
+// Drives a MappingRunner for a number of frames using the simulated clock and a fixed random seed, so that the
+// rendered output is identical on every run and can be compared against previously recorded (golden) frames.
+// Frames are rendered exactly frame_delay ms apart, independent of how long rendering actually takes.
+// The runner's time source and random seed are only replaced while recording, and are restored afterwards
+class FrameRecorder {
+	public:
+		FrameRecorder(
+			MappingRunner& runner,			// Mapping runner to record
+			CRGB* leds,						// LED array to render into
+			uint16_t num_leds,				// Number of LEDs (length of leds)
+			uint16_t seed=1337				// Seed for random number generators
+		):
+			runner(runner),
+			leds(leds),
+			num_leds(num_leds),
+			seed(seed) {}
+
+		// Render through the high precision pipeline, as LEDuinoController::setHighPrecision(): each frame is mapped to leds16
+		// with newFrame16(), then brightness is applied and it is quantised to leds with temporal dithering (see DitherQuantiser)
+		void setHighPrecision(
+			CRGB16* leds16,					// 16 bit LED array (length num_leds)
+			uint8_t brightness=255,			// Brightness applied when quantising
+			bool dither=true				// Whether to dither when quantising
+		) {
+			this->leds16 = leds16;
+			this->brightness = brightness;
+			this->dither = dither;
+		}
+
+		// Render num_frames frames from the start of the mapping and return the hash of the whole sequence
+		// Optionally record the hash of each frame into frame_hashes (length num_frames),
+		// and the raw LED data of each frame into frames (length num_frames*num_leds)
+		uint32_t record(uint16_t num_frames, uint32_t* frame_hashes=nullptr, CRGB* frames=nullptr) {
+			this->begin();
+			uint32_t sequence_hash = hash_leds(this->leds, 0);
+			for (uint16_t frame=0; frame < num_frames; frame++) {
+				this->renderFrame();
+				if (frame_hashes != nullptr) {
+					frame_hashes[frame] = hash_leds(this->leds, this->num_leds);
+				}
+				if (frames != nullptr) {
+					memcpy(&frames[frame*this->num_leds], this->leds, this->num_leds*sizeof(CRGB));
+				}
+				sequence_hash = hash_leds(this->leds, this->num_leds, sequence_hash);
+			}
+			this->end();
+			return sequence_hash;
+		}
+
+		// Render num_frames frames from the start of the mapping and return the largest difference of any LED channel from
+		// reference_frames (length num_frames*num_leds, e.g. raw frames recorded by record() in another mode or configuration)
+		uint8_t maxError(uint16_t num_frames, const CRGB* reference_frames) {
+			this->begin();
+			uint8_t max_error = 0;
+			for (uint16_t frame=0; frame < num_frames; frame++) {
+				this->renderFrame();
+				max_error = max(max_error, max_frame_error(this->leds, &reference_frames[frame*this->num_leds], this->num_leds));
+			}
+			this->end();
+			return max_error;
+		}
+
+	protected:
+		// Switch runner to the simulated clock and fixed seed, and reset it with cleared LED arrays
+		void begin() {
+			this->previous_time_source = this->runner.getTimeSource();
+			this->previous_seeded = this->runner.hasRandomSeed();
+			this->previous_seed = this->runner.getRandomSeed();
+			this->runner.setTimeSource(simulated_millis);
+			this->runner.setRandomSeed(this->seed);
+			simulated_time = 0;
+			fill_solid(this->leds, this->num_leds, CRGB::Black);
+			if (this->leds16 != nullptr) {
+				for (uint16_t i=0; i < this->num_leds; i++) {
+					this->leds16[i] = CRGB16();
+				}
+				this->quantiser = DitherQuantiser();
+				this->quantiser.setBrightness(this->brightness);
+				this->quantiser.setDither(this->dither);
+			}
+			this->runner.reset();
+		}
+
+		// Advance the simulated clock by one frame and render it
+		void renderFrame() {
+			simulated_time += this->runner.getFrameDelay();
+			if (this->leds16 != nullptr) {
+				this->runner.newFrame16(this->leds16, this->leds, this->num_leds);
+				this->quantiser.quantise(this->leds16, this->leds, this->num_leds);
+			} else {
+				this->runner.newFrame(this->leds);
+			}
+		}
+
+		// Restore the runner's own time source and seed
+		void end() {
+			this->runner.setTimeSource(this->previous_time_source);
+			if (this->previous_seeded) {
+				this->runner.setRandomSeed(this->previous_seed);
+			} else {
+				this->runner.clearRandomSeed();
+			}
+		}
+
+		MappingRunner& runner;
+		CRGB* leds;
+		const uint16_t num_leds;
+		const uint16_t seed;
+		CRGB16* leds16=nullptr;				// 16 bit LED array, if rendering in high precision
+		uint8_t brightness=255;
+		bool dither=true;
+		DitherQuantiser quantiser;
+		TimeSource previous_time_source=system_millis;
+		uint16_t previous_seed=0;
+		bool previous_seeded=false;
+};
+
+#endif
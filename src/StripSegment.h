@@ -69,6 +69,8 @@ class SpatialStripSegment_T 	{
 		virtual Bounds get_bounds() = 0;
 		// Get spatial position of an LED on the segment 
 		virtual Point getSpatialPosition(uint16_t segment_pos)	= 0;
+		// RAM used by spatial segment, including LED positions (not including StripSegment)
+		virtual size_t memoryUsage() const { return sizeof(*this); }
 
 		const StripSegment& strip_segment;		// LED Strip segment for axis
 
@@ -112,6 +114,10 @@ class SpatialStripSegment : public SpatialStripSegment_T {
 			segment_pos = limit(segment_pos, t_segment_length-1);
 			return this->led_positions[segment_pos];
 		}
+
+		size_t memoryUsage() const override {
+			return sizeof(*this);
+		}
 		
 	protected:
 		// Use Array class to allow providing position array inline to constructor
@@ -120,7 +126,7 @@ class SpatialStripSegment : public SpatialStripSegment_T {
 
 // Get the bounding box of a collection of Spatial Segments
 Bounds get_spatial_segment_bounds(SpatialStripSegment_T* spatial_segments[], uint16_t num_segments) {
-	Point global_max(FLT_MIN, FLT_MIN, FLT_MIN);
+	Point global_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 	Point global_min(FLT_MAX, FLT_MAX, FLT_MAX);
 	
 	for (uint16_t i=0; i<num_segments; i++) {
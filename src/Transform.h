@@ -0,0 +1,161 @@
+#ifndef Transform_h
+#define  Transform_h
+#include <math.h>
+#include "Point.h"
+
+// Affine transformation of points (3x3 matrix applied to point, followed by translation)
+// Equivalent to a 4x4 homogeneous transformation matrix with a bottom row of (0, 0, 0, 1)
+struct AffineTransform {
+	float m[3][3]={{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};	// Linear transformation (rows)
+	Point translation;									// Translation applied after linear transformation
+
+	// Transform which subtracts offset and then scales each axis (e.g. project coordinates to pattern coordinates)
+	static AffineTransform offsetScale(const Point& offset, const Point& scale_factors) {
+		AffineTransform transform;
+		transform.m[0][0] = scale_factors.x;
+		transform.m[1][1] = scale_factors.y;
+		transform.m[2][2] = scale_factors.z;
+		transform.translation = -transform.applyLinear(offset);
+		return transform;
+	}
+
+	// Transform which moves points by 'offset'
+	static AffineTransform translate(const Point& offset) {
+		AffineTransform transform;
+		transform.translation = offset;
+		return transform;
+	}
+
+	// Transform which scales each axis about the origin
+	static AffineTransform scale(const Point& scale_factors) {
+		return offsetScale(Point(0, 0, 0), scale_factors);
+	}
+
+	// Apply linear part of transformation only (e.g. for direction vectors)
+	Point applyLinear(const Point& p) const {
+		return Point(
+			this->m[0][0]*p.x + this->m[0][1]*p.y + this->m[0][2]*p.z,
+			this->m[1][0]*p.x + this->m[1][1]*p.y + this->m[1][2]*p.z,
+			this->m[2][0]*p.x + this->m[2][1]*p.y + this->m[2][2]*p.z
+		);
+	}
+
+	// Apply transformation to point
+	Point apply(const Point& p) const {
+		return this->applyLinear(p) + this->translation;
+	}
+
+	// Combined transformation which applies 'other' first, then this transformation
+	AffineTransform operator*(const AffineTransform& other) const {
+		AffineTransform result;
+		for (uint8_t row=0; row < 3; row++) {
+			for (uint8_t col=0; col < 3; col++) {
+				result.m[row][col] = this->m[row][0]*other.m[0][col] + this->m[row][1]*other.m[1][col] + this->m[row][2]*other.m[2][col];
+			}
+		}
+		result.translation = this->apply(other.translation);
+		return result;
+	}
+
+	bool operator==(const AffineTransform& other) const {
+		for (uint8_t row=0; row < 3; row++) {
+			for (uint8_t col=0; col < 3; col++) {
+				if (this->m[row][col] != other.m[row][col]) return false;
+			}
+		}
+		return this->translation == other.translation;
+	}
+
+	bool operator!=(const AffineTransform& other) const {
+		return !(*this == other);
+	}
+};
+
+// Unit quaternion representing a rotation, for combining rotations about different axes without gimbal lock
+struct Quaternion {
+	float w=1, x=0, y=0, z=0;
+
+	Quaternion() {}
+	Quaternion(float w, float x, float y, float z): w(w), x(x), y(y), z(z) {}
+
+	// Rotation of 'angle' radians about 'axis' (right-handed, axis does not need to be normalised)
+	static Quaternion fromAxisAngle(const Point& axis, float angle) {
+		float s = sinf(angle/2)/axis.norm();
+		return Quaternion(cosf(angle/2), axis.x*s, axis.y*s, axis.z*s);
+	}
+
+	// Combined rotation which applies 'other' first, then this rotation
+	Quaternion operator*(const Quaternion& other) const {
+		return Quaternion(
+			this->w*other.w - this->x*other.x - this->y*other.y - this->z*other.z,
+			this->w*other.x + this->x*other.w + this->y*other.z - this->z*other.y,
+			this->w*other.y - this->x*other.z + this->y*other.w + this->z*other.x,
+			this->w*other.z + this->x*other.y - this->y*other.x + this->z*other.w
+		);
+	}
+
+	// Re-normalise, to correct rounding errors after many rotations have been combined
+	void normalise() {
+		float inv_norm = 1/sqrtf(this->w*this->w + this->x*this->x + this->y*this->y + this->z*this->z);
+		this->w *= inv_norm;
+		this->x *= inv_norm;
+		this->y *= inv_norm;
+		this->z *= inv_norm;
+	}
+
+	// Rotation matrix of quaternion, for applying the rotation to many points
+	AffineTransform toTransform() const {
+		AffineTransform transform;
+		transform.m[0][0] = 1 - 2*(this->y*this->y + this->z*this->z);
+		transform.m[0][1] = 2*(this->x*this->y - this->w*this->z);
+		transform.m[0][2] = 2*(this->x*this->z + this->w*this->y);
+		transform.m[1][0] = 2*(this->x*this->y + this->w*this->z);
+		transform.m[1][1] = 1 - 2*(this->x*this->x + this->z*this->z);
+		transform.m[1][2] = 2*(this->y*this->z - this->w*this->x);
+		transform.m[2][0] = 2*(this->x*this->z - this->w*this->y);
+		transform.m[2][1] = 2*(this->y*this->z + this->w*this->x);
+		transform.m[2][2] = 1 - 2*(this->x*this->x + this->y*this->y);
+		return transform;
+	}
+};
+
+// Rotation about a fixed axis through the origin, where the parts of the rotation matrix which only depend on the axis
+// are pre-calculated (Rodrigues' formula: R = I + sin(angle)*K + (1-cos(angle))*K^2), so changing the angle
+// only needs one sin() and cos() and a few multiply-adds
+class AxisRotation {
+	public:
+		AxisRotation(
+			Point axis=Point(0, 0, 1)		// Axis of rotation (does not need to be normalised)
+		) {
+			Point u = axis/axis.norm();
+			// Cross product matrix of unit axis
+			float k[3][3] = {{0, -u.z, u.y}, {u.z, 0, -u.x}, {-u.y, u.x, 0}};
+			for (uint8_t row=0; row < 3; row++) {
+				for (uint8_t col=0; col < 3; col++) {
+					this->k[row][col] = k[row][col];
+					this->k2[row][col] = k[row][0]*k[0][col] + k[row][1]*k[1][col] + k[row][2]*k[2][col];
+				}
+			}
+		}
+
+		// Rotation of 'angle' radians about the axis
+		AffineTransform at(float angle) const {
+			float s = sinf(angle), c = 1 - cosf(angle);
+			AffineTransform transform;
+			for (uint8_t row=0; row < 3; row++) {
+				for (uint8_t col=0; col < 3; col++) {
+					transform.m[row][col] = (row == col) + s*this->k[row][col] + c*this->k2[row][col];
+				}
+			}
+			return transform;
+		}
+
+	protected:
+		float k[3][3];		// Cross product matrix of unit axis
+		float k2[3][3];		// Square of cross product matrix
+};
+
+// Function which gives the transformation to apply to pattern coordinates for a frame (e.g. to animate rotation or movement)
+typedef AffineTransform (*TransformFunction)(uint16_t frame_time);
+
+#endif
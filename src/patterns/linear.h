@@ -7,41 +7,71 @@
 // Lights all LEDs up in one random color, then fades to the next random color.
 // Can use a ConstantHuePicker to just have a constant solid color
 // Adapted from WLED by Aircookie
-class RandomColorFadePattern: public LinearPattern	{
+class RandomColorFadePattern: public SizedPattern<RandomColorFadePattern, LinearPattern>	{
 	public:
 		RandomColorFadePattern(
 			uint8_t cycle_time=128, 	// Color cycle time in 16th of a second
 			uint8_t fade_time=128,		// Time taken to fade to next colour as fraction of cycle_time
 			const ColorPicker& color_picker=Basic_picker):		
-		  LinearPattern(color_picker), 
+		  SizedPattern(color_picker), 
 		  cycle_time(cycle_time),
-		  fadedur(uint16_t(fade_time*cycle_time) >> 8) {}
+		  fadedur(uint16_t(fade_time*cycle_time) >> 8),
+		  cycle_time_ms(cycle_time << 6) {}
 		
+		void reset() override {
+			LinearPattern::reset();
+			this->prev_change_time = 0;
+			this->color = this->prev_color = 0;
+		}
+
 		void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time)	override {
-			static uint32_t prev_change_time = 0;
-			static uint16_t cycle_time_ms = this->cycle_time << 6;
-			static uint8_t color, prev_color;
-			uint16_t fade;
-			uint32_t change_time = frame_time / cycle_time_ms;
-			uint32_t rem = frame_time % cycle_time_ms;
-
-			if (change_time != prev_change_time) //new color
+			uint8_t fade = this->update(frame_time) >> 8;
+			this->fill_color = blend(this->getColor(this->prev_color), this->getColor(this->color), fade);
+			fill_solid(pixel_data, num_pixels, this->fill_color);
+		}
+
+		// Fade with 16 bit precision, so slow fades between similar colours don't step
+		bool frameAction16(CRGB16* pixel_data, uint16_t num_pixels, uint32_t frame_time) override {
+			uint16_t fade = this->update(frame_time);
+			CRGB16 color = blend16(this->getColor(this->prev_color), this->getColor(this->color), fade);
+			this->fill_color = color.toCRGB();
+			for (uint16_t i=0; i < num_pixels; i++) {
+				pixel_data[i] = color;
+			}
+			return true;
+		}
+
+		// All pixels are the same colour
+		LayerState getLayerState() const override {
+			return this->fill_color ? LAYER_OPAQUE : LAYER_EMPTY;
+		}
+
+	protected:
+		// Choose next colour if the cycle has changed, and return fade from previous colour as 16 bit fraction
+		uint16_t update(uint32_t frame_time) {
+			uint32_t change_time = frame_time / this->cycle_time_ms;
+			uint32_t rem = frame_time % this->cycle_time_ms;
+
+			if (change_time != this->prev_change_time) //new color
 			{
-				prev_color = color;
-				color = new_random_value8(prev_color);
-				prev_change_time = change_time;
+				this->prev_color = this->color;
+				this->color = new_random_value8(this->prev_color);
+				this->prev_change_time = change_time;
 			}
 
 			if (this->fadedur) {
-				fade = (rem << 2) / (this->fadedur);
-				if (fade > 255) fade = 255;
+				uint32_t fade = (rem << 10) / (this->fadedur);
+				return fade > 65535 ? 65535 : fade;
 			} else {
-				fade = 255;
+				return 65535;
 			}
-			fill_solid(pixel_data, num_pixels, blend(this->getColor(prev_color), this->getColor(color), fade));
 		}
-	protected:
+
 		uint8_t cycle_time, fadedur;	// Cycle time and fade duration in 16th of a second
+		const uint16_t cycle_time_ms;	// Cycle time in ms
+		uint32_t prev_change_time=0;	// Number of colour cycles completed at previous frame
+		uint8_t color=0, prev_color=0;	// Current colour (hue) to fade to, and previous colour to fade from
+		CRGB fill_color;				// Colour of all pixels in last frame
 };
 
 // SCROLLING & WAVE PATTERNS
@@ -50,16 +80,20 @@ class RandomColorFadePattern: public LinearPattern	{
 // Animated, ever-changing rainbows.
 // by Mark Kriegsman. https://github.com/FastLED/FastLED/blob/master/examples/Pride2015/Pride2015.ino
 // Recommend setting resolution equal to or close to number of leds in strip segment
-class PridePattern: public LinearPattern	{
+class PridePattern: public SizedPattern<PridePattern, LinearPattern>	{
 	public:
 		PridePattern(uint8_t speed_factor=4):
-			LinearPattern(), 
+			SizedPattern(), 
 			speed_factor(speed_factor) {}
 		
+		void reset() override {
+			LinearPattern::reset();
+			this->pseudotime = 0;
+			this->last_frame_time = 0;
+			this->hue_offset16 = 0;
+		}
+
 		void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time)	override {
-			static uint32_t sPseudotime = 0;  // pseudo-time elapsed since pattern start
-			static uint32_t sLastMillis = 0;  // actual time of last frame
-			static uint16_t sHue16 = 0;       // Hue offset with 16-bit resolution
 			// beatsin88 is used to get more granular low BPMs
 			// Vary saturation slightly over time
 			uint8_t sat8 = beatsin88( 87*this->speed_factor, 220, 250);
@@ -70,17 +104,19 @@ class PridePattern: public LinearPattern	{
 			// varying time multiplyer, for varying rate of change of hue and brightness
 			uint8_t msmultiplier = beatsin88(240*this->speed_factor, 40, 240);
 
-			uint16_t hue16 = sHue16;//gHue * 256;
+			uint16_t hue16 = this->hue_offset16;//gHue * 256;
 			// Vary hue increment over time (measure of rainbow colour gradient)
 			uint16_t hueinc16 = beatsin88(113*this->speed_factor, 1, 3000);
 
-			uint16_t deltams = frame_time - sLastMillis ;  // Time since last frame
-			sLastMillis  = frame_time;
-			sPseudotime += deltams * msmultiplier;
+			uint16_t deltams = frame_time - this->last_frame_time;  // Time since last frame
+			this->last_frame_time = frame_time;
+			this->pseudotime += deltams * msmultiplier;
 			// Increase hue offset by varying  amount
-			sHue16 += deltams * beatsin88( 400, 5,9);
+			this->hue_offset16 += deltams * beatsin88( 400, 5,9);
 			// wave offset
-			uint16_t brightnesstheta16 = sPseudotime;
+			uint16_t brightnesstheta16 = this->pseudotime;
+			// Saturation is constant for the whole frame, so its scaling is only calculated once
+			RainbowConverter converter(sat8);
 
 			for (uint16_t i = 0 ; i < num_pixels; i++) {
 				hue16 += hueinc16;
@@ -95,108 +131,158 @@ class PridePattern: public LinearPattern	{
 				// Scale to 0-255 (add constant amount)
 				bri8 += (255 - brightdepth);
 
-				CRGB newcolor = CHSV( hue8, sat8, bri8);
-				
-				nblend(pixel_data[i], newcolor, 64);
+				// Convert to RGB and blend with previous frame
+				converter.convertBlend(pixel_data[i], hue8, bri8, 64);
 			}
 		}
+
 	protected:
 		const uint8_t speed_factor;  // Factor to increase rate of change of pattern parameters
+		uint32_t pseudotime=0;  		// pseudo-time elapsed since pattern start
+		uint32_t last_frame_time=0;  	// actual time of last frame
+		uint16_t hue_offset16=0;       	// Hue offset with 16-bit resolution
 };
 
 //Moing sine wave with randomised speed, duration and rainbow colour offset, and changes direction
 // Benefits from using higher resolution than segment length
-class RandomRainbowsPattern: public LinearPattern  {
+// The random state is changed in segments of random length. With a step time, the segment containing the current step is found
+// by continuing the random sequence from the current segment (or replaying it from the seed set on reset if seeking backwards)
+class RandomRainbowsPattern: public SizedPattern<RandomRainbowsPattern, LinearPattern>  {
   public:
-    RandomRainbowsPattern(): LinearPattern() {}
+    RandomRainbowsPattern(
+		uint16_t step_time=0		// Time of each movement step in ms (0 for one step per frame, see StepClock)
+	): SizedPattern(), clock(step_time) {}
 	
 	void reset() override{
 		LinearPattern::reset();
-		this->pos = 0;
-		this->randomize_state();
+		this->clock.reset();
+		this->start_rng = this->rng;
+		this->rewind();
+	}
+
+	bool isSeekable() const override {
+		return this->clock.seekable();
 	}
 	
 	void randomize_state() {
-		this->speed=random(1,6);
-		this->scale_factor = random(1,4);
-		if (random(2) == 1) {
+		this->speed = this->rng.inRange(1,6);
+		this->scale_factor = this->rng.inRange(1,4);
+		if (this->rng.next8() & 1) {
 			this->direction=!this->direction;
 		}
-		this->randomize_time = random(10, 200);
-		this->colour_offset = random(0,255);
-		this->dim = random(0, 7) == 6;
+		this->randomize_time = this->rng.inRange(10, 200);
+		this->colour_offset = this->rng.below(255);
+		this->dim = this->rng.below(7) == 6;
 	}
 	
 	void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time)  override {
-		if (randomize_time) {
-			randomize_time--;
-		} else {
-			this->randomize_state();
-		}
-		if (direction) {
-			this->pos = (this->pos + this->speed) % num_pixels;
-		} else {
-			this->pos = wrap_subtract(this->pos, this->speed, num_pixels);
-		}
+		this->update(num_pixels, frame_time);
 		for (uint16_t i = 0; i < num_pixels; i++) {
 		  pixel_data[i] = this->get_pixel_value(num_pixels, i);
 		}
 		
 	}
+
+	bool frameActionIndexed(uint8_t* indices, uint8_t* brightness, uint16_t num_pixels, uint32_t frame_time) override {
+		if (brightness == nullptr) {
+			return false;
+		}
+		this->update(num_pixels, frame_time);
+		for (uint16_t i = 0; i < num_pixels; i++) {
+		  uint8_t val = this->get_wave_value(num_pixels, i);
+		  indices[i] = (val+this->colour_offset) & 0xFF;
+		  brightness[i] = this->dim ? val>>1 : val;
+		}
+		return true;
+	}
 	 
 	CRGB get_pixel_value(uint16_t num_pixels, uint16_t i)  {
-		uint8_t virtual_pos = (255*(i + this->pos))/(num_pixels);
-		uint8_t val = cubicwave8(uint16_t(virtual_pos*this->scale_factor) & 0xFF);
+		uint8_t val = this->get_wave_value(num_pixels, i);
 		return this->getColor((val+this->colour_offset) & 0xFF, this->dim ? val>>1 : val);
 	}
-	  
+
 	protected:
+		// Move to position for frame
+		void update(uint16_t num_pixels, uint32_t frame_time) {
+			uint32_t step = this->clock.update(frame_time);
+			this->seek(step);
+			// Position moves by speed every step
+			int32_t offset = this->start_offset + this->signed_speed()*(int32_t) (step - this->segment_base);
+			this->pos = ((offset % num_pixels) + num_pixels) % num_pixels;
+		}
+
+		// Value of wave at pixel i (used for both colour and brightness)
+		uint8_t get_wave_value(uint16_t num_pixels, uint16_t i) const {
+			uint8_t virtual_pos = (255*(i + this->pos))/(num_pixels);
+			return cubicwave8(uint16_t(virtual_pos*this->scale_factor) & 0xFF);
+		}
+
+		// Start again from the first segment of random state
+		void rewind() {
+			this->rng = this->start_rng;
+			this->direction = false;
+			this->randomize_state();
+			this->start_offset = 0;
+			this->segment_base = 0;
+			this->segment_end = this->randomize_time + 1;
+		}
+
+		// Move to the segment of random state containing step. The first segment is steps 0 to randomize_time,
+		// and following segments are randomize_time + 1 steps long
+		void seek(uint32_t step) {
+			if (this->segment_base > 0 && step <= this->segment_base) {
+				this->rewind();
+			}
+			while (step >= this->segment_end) {
+				// Position at last step of current segment
+				this->start_offset += this->signed_speed()*(int32_t) (this->segment_end - 1 - this->segment_base);
+				this->segment_base = this->segment_end - 1;
+				this->randomize_state();
+				this->segment_end += this->randomize_time + 1;
+			}
+		}
+
+		int32_t signed_speed() const {
+			return this->direction ? this->speed : -this->speed;
+		}
+
 		uint8_t speed;
 		bool direction=false;
-		uint8_t pos;    // Position from 0 to resolution
+		uint16_t pos;    // Position from 0 to resolution
 		uint8_t colour_offset;
-		uint16_t randomize_time;	// How long until state is randomized again
+		uint16_t randomize_time;	// Length of current segment of random state (in steps)
+		StepClock clock;
+		FastRandom start_rng;		// Random number generator state after reset
+		int32_t start_offset=0;		// Position (without wrapping) at segment_base
+		uint32_t segment_base=0;	// Step before first step of current segment
+		uint32_t segment_end=0;		// First step after current segment
 		uint8_t scale_factor;
 		bool dim;  //Whether to make pattern very dim (can look cool)
 };
 
 // Extends head to end of strip then retracts tail
-class GrowThenShrinkPattern : public LinearPattern  {
+class GrowThenShrinkPattern : public SizedPattern<GrowThenShrinkPattern, LinearPattern>  {
 	public:
-		GrowThenShrinkPattern(const ColorPicker& color_picker=Basic_picker):
-		LinearPattern(color_picker) {}
+		GrowThenShrinkPattern(
+			const ColorPicker& color_picker=Basic_picker,
+			uint16_t step_time=0		// Time of each step in ms (0 for one step per frame, see StepClock)
+		):
+		SizedPattern(color_picker),
+		clock(step_time) {}
 		
 		void reset() override {
 			LinearPattern::reset();
+			this->clock.reset();
 			this->head_pos = this->tail_pos = 0;
-			this->reverse = false;
+		}
+
+		bool isSeekable() const override {
+			return this->clock.seekable();
 		}
 
 		void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time) override {
 			// Update head and tail positions
-			if (this->reverse) 	{
-				if (this->tail_pos > 0)	{
-					// Extend along light strip
-					this->tail_pos--;
-				} else if (this->head_pos > 0) {
-					// Retract tail
-					this->head_pos--;
-				} else {
-					// Reverse
-					this->reverse = false;
-				}	
-			} else {
-				if (this->head_pos < num_pixels-1)	{
-					// Extend along light strip
-					this->head_pos++;
-				} else if (this->tail_pos < this->head_pos) {
-					// Retract tail
-					this->tail_pos++;
-				} else {
-					// Reverse
-					this->reverse = true;
-				}	
-			}
+			this->set_positions(this->clock.update(frame_time), num_pixels);
 
 			// Set pixel data
 			for (uint16_t i=0; i<num_pixels; i++) {
@@ -208,50 +294,119 @@ class GrowThenShrinkPattern : public LinearPattern  {
 			}
 		}
 
+		bool frameActionIndexed(uint8_t* indices, uint8_t* brightness, uint16_t num_pixels, uint32_t frame_time) override {
+			if (brightness == nullptr) {
+				return false;
+			}
+			this->set_positions(this->clock.update(frame_time), num_pixels);
+			for (uint16_t i=0; i<num_pixels; i++) {
+				indices[i] = (i*255)/num_pixels;
+				brightness[i] = ((this->tail_pos <= i) && (i <= this->head_pos)) ? 255 : 0;
+			}
+			return true;
+		}
+
 	protected:
+		// Set head and tail positions after 'step' steps. Each cycle is 4*(num_pixels - 1) + 2 steps: the head extends to the end,
+		// the tail retracts to the end, then after one step to reverse the tail extends back to the start, the head retracts
+		// to the start, and there is one step to reverse again
+		void set_positions(uint32_t step, uint16_t num_pixels) {
+			uint32_t end = num_pixels - 1;
+			uint32_t phase = step % (4*end + 2);
+			if (phase <= end) {
+				// Extend along light strip
+				this->head_pos = phase;
+				this->tail_pos = 0;
+			} else if (phase <= 2*end) {
+				// Retract tail
+				this->head_pos = end;
+				this->tail_pos = phase - end;
+			} else if (phase <= 3*end + 1) {
+				// Reverse, and extend back along light strip
+				this->head_pos = end;
+				this->tail_pos = 3*end + 1 - phase;
+			} else {
+				// Retract head, then reverse
+				this->head_pos = 4*end + 1 - phase;
+				this->tail_pos = 0;
+			}
+		}
+
 		uint16_t head_pos, tail_pos;
-		bool reverse;
+		StepClock clock;
 };
 
 
 // DYNAMIC MOVEMENT & ACTIVE PATTERNS
 
 // Simple moving pulse of light along axis. Pulse has a bright head with a tapering tail
-class MovingPulsePattern: public LinearPattern   {
+class MovingPulsePattern: public SizedPattern<MovingPulsePattern, LinearPattern>   {
   public:
     MovingPulsePattern(
 		uint8_t pulse_len=3, 	// Length of pulse 
-		const ColorPicker& color_picker=Basic_picker):
-      LinearPattern(color_picker), 
+		const ColorPicker& color_picker=Basic_picker,
+		uint16_t step_time=0):	// Time for pulse to move one pixel in ms (0 to move one pixel per frame, see StepClock)
+      SizedPattern(color_picker), 
 	  head_pos(0), 
 	  pulse_len(pulse_len), 	
-	  tail_interpolator(Interpolator(0, 255, pulse_len + 1, 0))  {}
+	  tail_interpolator(Interpolator(0, 255, pulse_len + 1, 0)),
+	  clock(step_time)  {}
+
+    void reset() override {
+      LinearPattern::reset();
+      this->clock.reset();
+      this->head_pos = 0;
+    }
+
+    bool isSeekable() const override {
+      return this->clock.seekable();
+    }
 
     // Update pulse position (on virtual axis)
     void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time)  override {
-      this->head_pos = (this->head_pos + 1) % num_pixels;
+      this->head_pos = this->clock.update(frame_time) % num_pixels;
 	  for (uint16_t i=0; i<num_pixels; i++) {
 		  pixel_data[i] = this->get_pixel_value(num_pixels, i);
 	  }
     }
 
+    bool frameActionIndexed(uint8_t* indices, uint8_t* brightness, uint16_t num_pixels, uint32_t frame_time) override {
+      if (brightness == nullptr) {
+        return false;
+      }
+      this->head_pos = this->clock.update(frame_time) % num_pixels;
+	  for (uint16_t i=0; i<num_pixels; i++) {
+		  indices[i] = (i*255) / num_pixels;
+		  brightness[i] = this->get_pixel_brightness(num_pixels, i);
+	  }
+	  return true;
+    }
+
     // Construct pulse from head position
 	// i is from 0 -> resolution
     CRGB get_pixel_value(uint16_t num_pixels, uint16_t i) {
+		uint8_t lum = this->get_pixel_brightness(num_pixels, i);
+		// If not within pulse width, return black
+		if (!lum)	{
+			return CRGB::Black;
+		}
+		uint8_t hue = (i*255) / num_pixels; // Change colour along axis
+		return this->getColor(hue, lum);
+	}
+
+	// Brightness of pixel i (0 if not within pulse)
+	uint8_t get_pixel_brightness(uint16_t num_pixels, uint16_t i) {
 		// Figure out distance behind pulse head to get brightness
 		int distance_behind_head = this->head_pos - i;
 		// Case of when position is in front of pulse head (after head has looped around to start), so distance_behind_head is negative
 		if (distance_behind_head < 0)	{
 			distance_behind_head = num_pixels + distance_behind_head;
 		}
-		// If not within pulse width, return black
 		if (distance_behind_head > this->pulse_len)	{
-			return CRGB::Black;
+			return 0;
 		}
 		// Use interpolator to get brightness
-		uint8_t lum = tail_interpolator.get_value(distance_behind_head);
-		uint8_t hue = (i*255) / num_pixels; // Change colour along axis
-		return this->getColor(hue, lum);
+		return tail_interpolator.get_value(distance_behind_head);
 	}
 
   private:
@@ -259,35 +414,55 @@ class MovingPulsePattern: public LinearPattern   {
     uint16_t head_pos;    				// Position of head of pulse
     uint8_t pulse_len;        			// Length of pulse 
 	Interpolator tail_interpolator;  	// Linear Interpolator for pulse tail brightness
+	StepClock clock;
 	
 };
 
 //https://gist.github.com/kriegsman/626dca2f9d2189bd82ca
 // *Flashing* rainbow lights that zoom back and forth to a beat.
-class DiscoStrobePattern : public LinearPattern  {
+class DiscoStrobePattern : public SizedPattern<DiscoStrobePattern, LinearPattern>  {
   public:
     DiscoStrobePattern(
 		const ColorPicker& color_picker=HalloweenColors_picker):
-      LinearPattern(color_picker) {}
+      SizedPattern(color_picker) {}
 	
+	// Parameter 0: tempo (BPM) to use if it is not being detected by an AudioAnalyzer
+	void setParameter(uint8_t param_id, int32_t value) override {
+		if (param_id == 0) {
+			this->bpm = value;
+		}
+	}
+
+	// Frames outside of the strobe phase are all black
+	LayerState getLayerState() const override {
+		return this->strobe_phase == 0 ? LAYER_PARTIAL : LAYER_EMPTY;
+	}
+
+	void reset() override {
+		LinearPattern::reset();
+		this->strobe_phase = 0;
+		this->repeat_counter = 0;
+		this->start_position = 0;
+		this->start_hue = 0;
+	}
+
 	void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time)	override {
 		// First, we black out all the LEDs
 		fill_solid(pixel_data, num_pixels, CRGB::Black);
 		
 		// To achive the strobe effect, we actually only draw lit pixels
 		// every Nth frame (e.g. every 4th frame).  
-		// sStrobePhase is a counter that runs from zero to kStrobeCycleLength-1,
+		// strobe_phase is a counter that runs from zero to kStrobeCycleLength-1,
 		// and then resets to zero.  
 		const uint8_t kStrobeCycleLength = 4; // light every Nth frame
-		static uint8_t sStrobePhase = 0;
-		sStrobePhase = sStrobePhase + 1;
-		if( sStrobePhase >= kStrobeCycleLength ) { 
-			sStrobePhase = 0; 
+		this->strobe_phase = this->strobe_phase + 1;
+		if( this->strobe_phase >= kStrobeCycleLength ) { 
+			this->strobe_phase = 0; 
 		}
 
 		// We only draw lit pixels when we're in strobe phase zero; 
 		// in all the other phases we leave the LEDs all black.
-		if( sStrobePhase == 0 ) {
+		if( this->strobe_phase == 0 ) {
 			// The dash spacing cycles from 4 to 9 and back, 8x/min (about every 7.5 sec)
 			uint8_t dashperiod= beatsin8( 8/*cycles per minute*/, 4,10);
 			// The width of the dashes is a fraction of the dashperiod, with a minimum of one pixel
@@ -306,6 +481,8 @@ class DiscoStrobePattern : public LinearPattern  {
 			// The dashes zoom back and forth at a speed that 'goes well' with
 			// most dance music, a little faster than 120 Beats Per Minute.  You
 			// can adjust this for faster or slower 'zooming' back and forth.
+			// Follow the tempo of the music if it has been detected by an AudioAnalyzer
+			uint8_t bpm = this->audio().bpm ? this->audio().bpm : this->bpm;
 			int8_t  dashmotionspeed = beatsin8( (bpm /2), 1,dashperiod);
 			// This is where we reverse the direction under cover of high speed
 			// visual aliasing.
@@ -346,6 +523,7 @@ class DiscoStrobePattern : public LinearPattern  {
 		}
 
 	}
+
 	protected:
 		// discoWorker updates the positions of the dashes, and calls the draw function
 		void discoWorker( 
@@ -354,30 +532,26 @@ class DiscoStrobePattern : public LinearPattern  {
 			uint8_t stroberepeats,
 			uint8_t huedelta)
 		 {
-		  static uint8_t sRepeatCounter = 0;
-		  static int8_t sStartPosition = 0;
-		  static uint8_t sStartHue = 0;
-
 		  // Always keep the hue shifting a little
-		  sStartHue += 1;
+		  this->start_hue += 1;
 
 		  // Increment the strobe repeat counter, and
 		  // move the dash starting position when needed.
-		  sRepeatCounter = sRepeatCounter + 1;
-		  if( sRepeatCounter>= stroberepeats) {
-			sRepeatCounter = 0;
+		  this->repeat_counter = this->repeat_counter + 1;
+		  if( this->repeat_counter >= stroberepeats) {
+			this->repeat_counter = 0;
 			
-			sStartPosition = sStartPosition + dashmotionspeed;
+			this->start_position = this->start_position + dashmotionspeed;
 			
 			// These adjustments take care of making sure that the
 			// starting hue is adjusted to keep the apparent color of 
 			// each dash the same, even when the state position wraps around.
-			if( sStartPosition >= dashperiod ) {
-			  while( sStartPosition >= dashperiod) { sStartPosition -= dashperiod; }
-			  sStartHue  -= huedelta;
-			} else if( sStartPosition < 0) {
-			  while( sStartPosition < 0) { sStartPosition += dashperiod; }
-			  sStartHue  += huedelta;
+			if( this->start_position >= dashperiod ) {
+			  while( this->start_position >= dashperiod) { this->start_position -= dashperiod; }
+			  this->start_hue  -= huedelta;
+			} else if( this->start_position < 0) {
+			  while( this->start_position < 0) { this->start_position += dashperiod; }
+			  this->start_hue  += huedelta;
 			}
 		  }
 
@@ -388,8 +562,8 @@ class DiscoStrobePattern : public LinearPattern  {
 
 		  // call the function that actually just draws the dashes now
 		  this->drawRainbowDashes(pixel_data, num_pixels,
-		   						sStartPosition, dashperiod, dashwidth, 
-							 	sStartHue, huedelta, kSaturation, kValue);
+		   						this->start_position, dashperiod, dashwidth, 
+							 	this->start_hue, huedelta, kSaturation, kValue);
 		}
 		// drawRainbowDashes - draw rainbow-colored 'dashes' of light along the led strip:
 		//   starting from 'startpos', up to and including 'lastpos'
@@ -426,16 +600,20 @@ class DiscoStrobePattern : public LinearPattern  {
 		  }
 		}
 		uint8_t bpm=61;
+		uint8_t strobe_phase=0;		// Counter of frames within strobe cycle
+		uint8_t repeat_counter=0;	// Counter of strobe repeats at current dash position
+		int8_t start_position=0;	// Start position of first dash
+		uint8_t start_hue=0;		// Hue of first dash
 };
 
 // Pulse which jumps to random position on segment and flashes
-class SkippingSpikePattern: public LinearPattern  {
+class SkippingSpikePattern: public SizedPattern<SkippingSpikePattern, LinearPattern>  {
   public:
     SkippingSpikePattern(
       uint8_t max_pulse_width,
       uint8_t pulse_speed=1,
 	  const ColorPicker& color_picker=RainbowColors_picker):
-      LinearPattern(color_picker),
+      SizedPattern(color_picker),
 	    max_pulse_width(max_pulse_width),
 	    pulse_speed(pulse_speed) {}
 	 
@@ -447,6 +625,29 @@ class SkippingSpikePattern: public LinearPattern  {
     }
 
     void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time)  override {
+        this->update_pulse(num_pixels);
+		// Fill pixel array
+		for (uint16_t i=0; i < num_pixels; i++) 	{
+			uint8_t lum = this->get_pixel_brightness(i);
+			pixel_data[i] = lum ? this->getColor(255-lum, lum) : CRGB::Black;
+		}
+    }
+
+    bool frameActionIndexed(uint8_t* indices, uint8_t* brightness, uint16_t num_pixels, uint32_t frame_time) override {
+        if (brightness == nullptr) {
+          return false;
+        }
+        this->update_pulse(num_pixels);
+		for (uint16_t i=0; i < num_pixels; i++) 	{
+			brightness[i] = this->get_pixel_brightness(i);
+			indices[i] = 255 - brightness[i];
+		}
+		return true;
+    }
+
+	protected:
+    // Expand or contract pulse, and move it when it ends
+    void update_pulse(uint16_t num_pixels) {
         if (this->ramp_up) {	// Pulse expanding		
           if (this->max_pulse_width-this->ramp <= this->pulse_speed) {  // Reached top of pulse
             this->ramp_up = false;
@@ -456,7 +657,7 @@ class SkippingSpikePattern: public LinearPattern  {
         } else {  // Pulse contracting
           if (this->ramp <= this->pulse_speed) {  // End of pulse
             // Move pulse position
-            this->pulse_pos = (this->max_pulse_width/4) + random(0, num_pixels - this->max_pulse_width/4);
+            this->pulse_pos = (this->max_pulse_width/4) + this->rng.below(num_pixels - this->max_pulse_width/4);
             /*
             if ((this->resolution - pulse_pos) <= pulse_offset) {
               // Loop over position back to start
@@ -470,21 +671,18 @@ class SkippingSpikePattern: public LinearPattern  {
             this->ramp -= this->pulse_speed;  
           }
         }
+    }
 
-		// Fill pixel array
-		for (uint16_t i=0; i < num_pixels; i++) 	{
+		// Brightness of pixel i (0 if outside pulse)
+		uint8_t get_pixel_brightness(uint16_t i) const {
 			// Get distance of pixel from pulse_pos
 			uint8_t diff = i >= this->pulse_pos ? i - this->pulse_pos : this->pulse_pos - i;
 			if (diff > this->ramp) {
-				pixel_data[i] = CRGB::Black;
-			} else {
-				uint8_t lum = (255 - (diff*255)/this->ramp);
-				pixel_data[i] = this->getColor(255-lum, lum);
+				return 0;
 			}
+			return 255 - (diff*255)/this->ramp;
 		}
-    }
 
-	protected:
 		const uint8_t max_pulse_width, pulse_speed;
 		uint16_t pulse_pos; //Position of current pulse
 		uint8_t ramp;
@@ -520,37 +718,67 @@ void coolLikeIncandescent( CRGB& c, uint8_t phase)
 //  I chose a sawtooth triangle wave (triwave8) rather than a sine wave,
 //  but the idea is the same: brightness = triwave8( time ).
 // 	Works well when resolution is equal to segment length
-class TwinklePattern : public LinearPattern   {
+// Each pixel has a constant clock offset, speed and 'salt', which can be stored in a table so that they are only generated
+// when the pattern is reset or the resolution changes (otherwise they are regenerated every frame, using less memory)
+
+// Constant twinkle parameters of a pixel
+struct TwinkleParameters {
+	uint16_t clock_offset;			// Offset of pixel clock
+	uint8_t speed_multiplier;		// Clock speed adjustment factor (Q5.3, from 8/8ths to 23/8ths)
+	uint8_t salt;					// Unique value for pixel
+};
+
+class TwinklePattern : public SizedPattern<TwinklePattern, LinearPattern>   {
   public:
     TwinklePattern(
 		uint8_t twinkle_speed = 6, 
 		uint8_t twinkle_density = 4, 
 		const ColorPicker& color_picker = FairyLight_picker, 
-		CRGB bg = CRGB::Black):
-      LinearPattern(color_picker), 
+		CRGB bg = CRGB::Black,
+		TwinkleParameters* parameter_table = nullptr,		// Optional table to store pixel parameters (nullptr to regenerate them every frame)
+		uint16_t table_size = 0):							// Length of parameter_table (should be at least the pattern resolution)
+      SizedPattern(color_picker), 
 	  bg(bg), 
 	  bg_brightness(bg.getAverageLight()), 
 	  twinkle_speed(twinkle_speed), 
-	  twinkle_density(twinkle_density)  {}
+	  twinkle_density(twinkle_density),
+	  parameter_table(parameter_table),
+	  table_size(table_size)  {}
+
+    void reset() override {
+      LinearPattern::reset();
+      // Parameters are generated again on next frame
+      this->table_pixels = 0;
+    }
+
+    // Pixel values only depend on frame_time
+    bool isSeekable() const override {
+      return true;
+    }
+
+    // Parameter 0: twinkle speed (0-8), parameter 1: twinkle density (0-8)
+    void setParameter(uint8_t param_id, int32_t value) override {
+      if (param_id == 0) {
+        this->twinkle_speed = constrain(value, 0, 8);
+      } else if (param_id == 1) {
+        this->twinkle_density = constrain(value, 0, 8);
+      }
+    }
 
     void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time) override {
-		// "this->PRNG16" is the pseudorandom number generator
-		this->PRNG16 = 11337;
-		// Set pixel data
-		for (uint16_t i=0; i<num_pixels; i++) {
-		  pixel_data[i] = this->get_pixel_value(frame_time, i);
-		}
+		this->render(pixel_data, num_pixels, frame_time);
     }
 
-    CRGB get_pixel_value(uint16_t frame_time, uint16_t i)  {
+    // Twinkles fade in and out with 16 bit brightness, so the dim ends of each twinkle don't step
+    bool frameAction16(CRGB16* pixel_data, uint16_t num_pixels, uint32_t frame_time) override {
+		this->render(pixel_data, num_pixels, frame_time);
+		return true;
+    }
+
+    CRGB get_pixel_value(uint16_t frame_time, const TwinkleParameters& parameters)  {
       CRGB pixel;
-      this->PRNG16 = (uint16_t)(this->PRNG16 * 2053) + 1384; // next 'random' number
-      uint16_t myclockoffset16 = this->PRNG16; // use that number as clock offset
-      this->PRNG16 = (uint16_t)(this->PRNG16 * 2053) + 1384; // next 'random' number
-      // use that number as clock speed adjustment factor (in 8ths, from 8/8ths to 23/8ths)
-      uint8_t myspeedmultiplierQ5_3 =  ((((this->PRNG16 & 0xFF) >> 4) + (this->PRNG16 & 0x0F)) & 0x0F) + 0x08;
-      uint32_t myclock30 = (uint32_t)((frame_time * myspeedmultiplierQ5_3) >> 3) + myclockoffset16;
-      uint8_t  myunique8 = this->PRNG16 >> 8; // get 'salt' value for this pixel
+      uint32_t myclock30 = (uint32_t)((frame_time * parameters.speed_multiplier) >> 3) + parameters.clock_offset;
+      uint8_t  myunique8 = parameters.salt;
 
       // We now have the adjusted 'clock' for this pixel, now we call
       // the function that computes what color the pixel should be based
@@ -573,7 +801,71 @@ class TwinklePattern : public LinearPattern   {
       }
       return pixel;
     }
+
+    // 16 bit version of get_pixel_value()
+    CRGB16 get_pixel_value16(uint16_t frame_time, const TwinkleParameters& parameters)  {
+      uint32_t myclock30 = (uint32_t)((frame_time * parameters.speed_multiplier) >> 3) + parameters.clock_offset;
+      CRGB16 c = computeOneTwinkle16( myclock30, parameters.salt);
+      uint8_t cbright = c.toCRGB().getAverageLight();
+      int16_t deltabright = cbright - bg_brightness;
+      if ( deltabright >= 32 || (!bg)) {
+        return c;
+      } else if ( deltabright > 0 ) {
+        return blend16( bg, c, deltabright * 8 * 257);
+      } else {
+        return bg;
+      }
+    }
+
+    size_t memoryUsage() const override {
+      return sizeof(*this) + this->table_size*sizeof(TwinkleParameters);
+    }
+
   protected:
+    // Set pixel values to pixel_data (CRGB or CRGB16), using parameter table if there is one
+    template<typename PixelT>
+    void render(PixelT* pixel_data, uint16_t num_pixels, uint32_t frame_time) {
+		if (this->parameter_table != nullptr && num_pixels <= this->table_size) {
+			// Generate parameter table if it has not been generated for this resolution
+			if (num_pixels != this->table_pixels) {
+				this->PRNG16 = 11337;
+				for (uint16_t i=0; i<num_pixels; i++) {
+					this->parameter_table[i] = this->next_parameters();
+				}
+				this->table_pixels = num_pixels;
+			}
+			for (uint16_t i=0; i<num_pixels; i++) {
+				this->set_pixel(pixel_data[i], frame_time, this->parameter_table[i]);
+			}
+		} else {
+			// "this->PRNG16" is the pseudorandom number generator, restarted every frame to regenerate the same parameters
+			this->PRNG16 = 11337;
+			for (uint16_t i=0; i<num_pixels; i++) {
+				this->set_pixel(pixel_data[i], frame_time, this->next_parameters());
+			}
+		}
+    }
+
+    void set_pixel(CRGB& pixel, uint16_t frame_time, const TwinkleParameters& parameters) {
+      pixel = this->get_pixel_value(frame_time, parameters);
+    }
+
+    void set_pixel(CRGB16& pixel, uint16_t frame_time, const TwinkleParameters& parameters) {
+      pixel = this->get_pixel_value16(frame_time, parameters);
+    }
+
+    // Generate parameters of next pixel from PRNG16
+    TwinkleParameters next_parameters() {
+      TwinkleParameters parameters;
+      this->PRNG16 = (uint16_t)(this->PRNG16 * 2053) + 1384; // next 'random' number
+      parameters.clock_offset = this->PRNG16; // use that number as clock offset
+      this->PRNG16 = (uint16_t)(this->PRNG16 * 2053) + 1384; // next 'random' number
+      // use that number as clock speed adjustment factor (in 8ths, from 8/8ths to 23/8ths)
+      parameters.speed_multiplier =  ((((this->PRNG16 & 0xFF) >> 4) + (this->PRNG16 & 0x0F)) & 0x0F) + 0x08;
+      parameters.salt = this->PRNG16 >> 8; // get 'salt' value for this pixel
+      return parameters;
+    }
+
     CRGB computeOneTwinkle( uint32_t ms, uint8_t salt) {
       uint16_t ticks = ms >> (8 - twinkle_speed);
       uint8_t fastcycle8 = ticks;
@@ -598,6 +890,45 @@ class TwinklePattern : public LinearPattern   {
       return c;
     }
 
+    // 16 bit version of computeOneTwinkle(), using the bits of the clock below the 8 bit phase for a 16 bit attack/decay wave
+    // The colour is picked at full brightness and scaled in 16 bits (instead of being picked at the twinkle brightness)
+    CRGB16 computeOneTwinkle16( uint32_t ms, uint8_t salt) {
+      uint16_t ticks = ms >> (8 - twinkle_speed);
+      uint16_t fastcycle16 = ms << twinkle_speed;
+      uint8_t fastcycle8 = ticks;
+      uint16_t slowcycle16 = (ticks >> 8) + salt;
+      slowcycle16 += sin8( slowcycle16);
+      slowcycle16 =  (slowcycle16 * 2053) + 1384;
+      uint8_t slowcycle8 = (slowcycle16 & 0xFF) + (slowcycle16 >> 8);
+
+      if ( ((slowcycle8 & 0x0E) / 2) >= twinkle_density) {
+        return CRGB16();
+      }
+      uint16_t bright = attackDecayWave16( fastcycle16);
+      if ( bright == 0) {
+        return CRGB16();
+      }
+      uint8_t hue = slowcycle8 - salt;
+      CRGB16 c = CRGB16(this->getColor(hue)).scale(bright);
+      // Same as coolLikeIncandescent()
+      if ( fastcycle8 >= 128) {
+        uint16_t cooling = ((fastcycle8 - 128) >> 4)*257;
+        c.g = c.g > cooling ? c.g - cooling : 0;
+        c.b = c.b > cooling*2 ? c.b - cooling*2 : 0;
+      }
+      return c;
+    }
+
+    // 16 bit version of attackDecayWave8() (rises over the first third of the phase, and falls over the rest)
+    static uint16_t attackDecayWave16( uint16_t i) {
+      if ( i < 21846) {
+        return i * 3;
+      } else {
+        i -= 21846;
+        return 65535 - (i + (i / 2));
+      }
+    }
+
     // Background colour
 	CRGB bg;
     uint8_t bg_brightness;
@@ -605,15 +936,18 @@ class TwinklePattern : public LinearPattern   {
     uint8_t twinkle_speed;     // 0-8
     uint8_t twinkle_density;   // 0-8
     uint16_t PRNG16;
+    TwinkleParameters* parameter_table;		// Table of pixel parameters (or nullptr)
+    const uint16_t table_size;
+    uint16_t table_pixels=0;				// Number of pixels parameter table has been generated for (0 if not generated)
 };
 
 
-class SparkleFillPattern : public LinearPattern {
+class SparkleFillPattern : public SizedPattern<SparkleFillPattern, LinearPattern> {
   public:
     SparkleFillPattern(const ColorPicker& color_picker=Basic_picker):
-      LinearPattern(color_picker) {}
+      SizedPattern(color_picker) {}
 	  
-	void reset() {
+	void reset() override {
 		LinearPattern::reset();
 		this->fill = true;
 		this->pixels_changed = 0;
@@ -621,10 +955,18 @@ class SparkleFillPattern : public LinearPattern {
 	
 	void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time)	override {
 		uint16_t remaining = num_pixels - this->pixels_changed;
+		// Probabilty to fill/un-fill each pixel is inversely proportional to amount remaining (1 in remaining, as fraction of 65536)
+		uint16_t probability = remaining > 1 ? 65536UL/remaining : 0;
+		uint32_t mask = 0;
 		for (uint16_t i=0; i < num_pixels; i++) 	{
-			uint8_t brightness = pixel_data[i].getAverageLight();
-			// Probabilty to fill/un-fill the pixel is inversely proportional to amount remaining
-			if (random(0,remaining) == 0) {
+			// Get decisions for next 32 pixels at once
+			if ((i & 31) == 0) {
+				mask = probability ? this->rng.bernoulliMask(probability) : 0xFFFFFFFF;
+			}
+			bool selected = mask & 1;
+			mask >>= 1;
+			if (selected) {
+				uint8_t brightness = pixel_data[i].getAverageLight();
 				// Fill with random palette value, or unfill
 				if (brightness) 	{
 					// Brighten existing pixel if filling
@@ -643,7 +985,7 @@ class SparkleFillPattern : public LinearPattern {
 					}
 				} else if (this->fill) {
 					// Fill with new colour
-					pixel_data[i] = this->getColor(random(0,256), 32);
+					pixel_data[i] = this->getColor(this->rng.next8(), 32);
 					this->pixels_changed++;
 				}
 				
@@ -655,7 +997,7 @@ class SparkleFillPattern : public LinearPattern {
 		}
 		
 	}
-	
+
 	protected:
 		bool fill=true;   // Whether pattern is in fill mode (True) or un-fill
 		uint16_t pixels_changed=0;	// Number of remaining pixels to fill/un-fill
@@ -664,13 +1006,13 @@ class SparkleFillPattern : public LinearPattern {
 
 //https://github.com/FastLED/FastLED/blob/master/examples/Fire2012WithPalette/Fire2012WithPalette.ino
 template<uint16_t t_resolution> 
-class FirePattern: public LinearPattern   {
+class FirePattern: public SizedPattern<FirePattern<t_resolution>, LinearPattern>   {
   public:
 		FirePattern(
 		uint8_t cooling=60,    	// Less cooling = taller flames.  More cooling = shorter flames. Default 60, suggested range 20-100 
 		uint8_t sparking=100,	// Higher chance = more roaring fire.  Lower chance = more flickery fire. Default 100, suggested range 50-200.
 		const ColorPicker& color_picker=HeatColors_picker): 
-		LinearPattern(color_picker),
+		SizedPattern<FirePattern<t_resolution>, LinearPattern>(color_picker),
 		cooling(cooling),  	
 		sparking(sparking)  
 		{};
@@ -684,36 +1026,57 @@ class FirePattern: public LinearPattern   {
 	}
 		
 	void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time) override {
-		random16_add_entropy(random());
-		// Step 1.  Cool down every cell a little
-		for(uint8_t i = 0; i < num_pixels; i++) {
-		  this->heat[i] = qsub8( this->heat[i],  random8(0, ((this->cooling * 10) / num_pixels) + 2));
+		this->update_heat(num_pixels);
+		// Fill pixel array
+		for (uint16_t i=0; i < num_pixels; i++) 	{
+			pixel_data[i] = this->getColor(this->color_index(num_pixels, i));
 		}
-	  
-		// Step 2.  Heat from each cell drifts 'up' and diffuses a little
-		for(uint8_t k= num_pixels - 1; k >= 2; k--) {
-		  this->heat[k] = (this->heat[k - 1] + 2*this->heat[k - 2]) / 3;
+	}
+
+	// Heat is already a palette index, so only one byte per pixel is needed
+	bool frameActionIndexed(uint8_t* indices, uint8_t* brightness, uint16_t num_pixels, uint32_t frame_time) override {
+		this->update_heat(num_pixels);
+		for (uint16_t i=0; i < num_pixels; i++) 	{
+			indices[i] = this->color_index(num_pixels, i);
+		}
+		if (brightness != nullptr) {
+			memset(brightness, 255, num_pixels);
 		}
+		return true;
+	}
+
+	protected:
+		// Update heat of each cell for the next frame
+		void update_heat(uint16_t num_pixels) {
+			// Step 1.  Cool down every cell a little (random bytes scaled to maximum cooling)
+			uint8_t max_cooling = ((this->cooling * 10) / num_pixels) + 2;
+			for(uint8_t i = 0; i < num_pixels; i++) {
+			  this->heat[i] = qsub8( this->heat[i],  scale8(this->rng.next8(), max_cooling));
+			}
+	  
+			// Step 2.  Heat from each cell drifts 'up' and diffuses a little
+			for(uint8_t k= num_pixels - 1; k >= 2; k--) {
+			  this->heat[k] = (this->heat[k - 1] + 2*this->heat[k - 2]) / 3;
+			}
 		
-		// Step 3.  Randomly ignite new 'sparks' of heat near the bottom
-		if(random8() < this->sparking ) {
-		  uint8_t y = random8(num_pixels/5 + 1);
-		  this->heat[y] = qadd8( this->heat[y], random8(160,220) );
+			// Step 3.  Randomly ignite new 'sparks' of heat near the bottom
+			if(this->rng.chance(this->sparking)) {
+			  uint8_t y = this->rng.below(num_pixels/5 + 1);
+			  this->heat[y] = qadd8( this->heat[y], this->rng.inRange(160,220) );
+			}
 		}
 
-		// Fill pixel array
-		for (uint16_t i=0; i < num_pixels; i++) 	{
+		// Palette index of pixel i
+		uint8_t color_index(uint16_t num_pixels, uint16_t i) const {
 			// Get heat value, Scale from 0-255 down to 0-240, select colour from palette
 			uint8_t colorindex = scale8(this->heat[i], 240);
 			// Constrain base heat (so base of fire doesnt look too bright
 			if (i < (num_pixels/10) + 1)	{
 				colorindex = constrain(colorindex, 40, 120);
 			}
-			pixel_data[i] = this->getColor(colorindex);
+			return colorindex;
 		}
-	}
-	   
-	protected:
+
 		uint8_t heat[t_resolution]; 		// Array to store heat values
 		const uint8_t cooling, sparking;
 	
@@ -0,0 +1,34 @@
+#include <FastLED.h>
+#include "Pattern.h"
+
+// Rainbow gradient moving diagonally across the matrix
+// Each row is the same gradient shifted by a fixed amount, so is filled as a single scanline
+class DiagonalRainbowPattern: public SizedPattern<DiagonalRainbowPattern, MatrixPattern> {
+	public:
+		DiagonalRainbowPattern(
+			uint8_t x_step=8,			// Change of hue between adjacent pixels in a row
+			uint8_t y_step=8,			// Change of hue between adjacent rows
+			uint8_t speed=16,			// Rate of change of hue over time
+			const ColorPicker& color_picker=RainbowColors_picker
+		):
+			SizedPattern(color_picker),
+			x_step(x_step),
+			y_step(y_step),
+			speed(speed) {}
+
+		// Pixel values only depend on frame_time
+		bool isSeekable() const override {
+			return true;
+		}
+
+		void rowAction(CRGB* row_data, uint16_t width, uint16_t y, uint32_t frame_time) override {
+			uint8_t hue = ((frame_time * this->speed) >> 8) + y*this->y_step;
+			for (uint16_t x=0; x < width; x++) {
+				row_data[x] = this->getColor(hue);
+				hue += this->x_step;
+			}
+		}
+
+	protected:
+		const uint8_t x_step, y_step, speed;
+};
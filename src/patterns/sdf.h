@@ -0,0 +1,350 @@
+#include <FastLED.h>
+#include "Pattern.h"
+#include "PointBuffer.h"
+#include "Transform.h"
+
+// Signed distance field (SDF) shapes, which give the distance from a point to the surface of the shape (negative inside).
+// Shapes are built from primitives combined with operators (which reference other shapes), and drawn with an SDFPattern.
+// Every shape has a bounding sphere (unless it is unbounded, e.g. a plane), so points further than 'max_distance' from
+// the bounding sphere are culled with a squared distance comparison instead of evaluating the shape.
+// When culled, distance() returns max_distance, so the result is only exact when its magnitude is below max_distance
+// (otherwise it is only known to be >= max_distance, or <= -max_distance)
+class SDFShape {
+	public:
+		SDFShape(
+			Point bound_centre=Point(0, 0, 0),		// Centre of bounding sphere
+			float bound_radius=-1					// Radius of bounding sphere (negative if shape is unbounded)
+		): bound_centre(bound_centre), bound_radius(bound_radius) {}
+
+		// Signed distance from point to surface, or max_distance if point is culled by the bounding sphere
+		float distance(const Point& point, float max_distance=FLT_MAX) const {
+			if (this->bound_radius >= 0 && max_distance < FLT_MAX) {
+				float cull_distance = this->bound_radius + max_distance;
+				if (point.distance_squared(this->bound_centre) >= cull_distance*cull_distance) {
+					return max_distance;
+				}
+			}
+			return this->shapeDistance(point, max_distance);
+		}
+
+		// Distance of every point in buffer (out must have length of at least points.size())
+		virtual void distances(const PointBuffer_T& points, float* out, float max_distance=FLT_MAX) const {
+			for (uint16_t i=0; i < points.size(); i++) {
+				out[i] = this->distance(points.get(i), max_distance);
+			}
+		}
+
+		const Point bound_centre;
+		const float bound_radius;
+
+	protected:
+		// Signed distance to surface (after culling). Operators pass max_distance to the shapes they combine
+		virtual float shapeDistance(const Point& point, float max_distance) const = 0;
+};
+
+// Radius of sphere containing the bounding spheres of two shapes (negative if either is unbounded)
+float sdf_union_radius(const SDFShape& a, const SDFShape& b, Point centre) {
+	if (a.bound_radius < 0 || b.bound_radius < 0) {
+		return -1;
+	}
+	return max(centre.distance(a.bound_centre) + a.bound_radius, centre.distance(b.bound_centre) + b.bound_radius);
+}
+
+class SDFSphere : public SDFShape {
+	public:
+		SDFSphere(
+			Point centre,		// Centre of sphere
+			float radius		// Radius of sphere
+		): SDFShape(centre, radius), radius(radius) {}
+
+		// Batched evaluation, comparing squared distances so only points near or inside the sphere need a sqrt
+		void distances(const PointBuffer_T& points, float* out, float max_distance=FLT_MAX) const override {
+			float cull_squared = FLT_MAX;
+			if (max_distance < FLT_MAX) {
+				cull_squared = (this->radius + max_distance)*(this->radius + max_distance);
+			}
+			for (uint16_t i=0; i < points.size(); i++) {
+				float distance_squared = points.get(i).distance_squared(this->bound_centre);
+				out[i] = distance_squared >= cull_squared ? max_distance : sqrtf(distance_squared) - this->radius;
+			}
+		}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			return sqrtf(point.distance_squared(this->bound_centre)) - this->radius;
+		}
+
+		const float radius;
+};
+
+// Axis-aligned box (use SDFTransformed to rotate it)
+class SDFBox : public SDFShape {
+	public:
+		SDFBox(
+			Point centre,		// Centre of box
+			Point half_size		// Half of the size of the box on each axis
+		): SDFShape(centre, half_size.norm()), half_size(half_size) {}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			Point p = point - this->bound_centre;
+			Point q(fabsf(p.x) - this->half_size.x, fabsf(p.y) - this->half_size.y, fabsf(p.z) - this->half_size.z);
+			float outside = Point(max(q.x, 0.0f), max(q.y, 0.0f), max(q.z, 0.0f)).norm();
+			float inside = min(max(q.x, max(q.y, q.z)), 0.0f);
+			return outside + inside;
+		}
+
+		const Point half_size;
+};
+
+// Infinite plane (negative on the opposite side to the normal vector)
+class SDFPlane : public SDFShape {
+	public:
+		SDFPlane(
+			Point normal,		// Normal vector of plane
+			Point point			// Point on plane
+		): SDFShape(), plane(normal, point) {}
+
+		void distances(const PointBuffer_T& points, float* out, float max_distance=FLT_MAX) const override {
+			points.planeDistance(this->plane, out);
+		}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			return this->plane.signed_distance(point);
+		}
+
+		const Plane plane;
+};
+
+// Torus lying in the xy plane (around the z axis), use SDFTransformed to orient it
+class SDFTorus : public SDFShape {
+	public:
+		SDFTorus(
+			Point centre,			// Centre of torus
+			float major_radius,		// Radius from centre to centre of tube
+			float minor_radius		// Radius of tube
+		): SDFShape(centre, major_radius + minor_radius), major_radius(major_radius), minor_radius(minor_radius) {}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			Point p = point - this->bound_centre;
+			float ring = sqrtf(p.x*p.x + p.y*p.y) - this->major_radius;
+			return sqrtf(ring*ring + p.z*p.z) - this->minor_radius;
+		}
+
+		const float major_radius, minor_radius;
+};
+
+// Line segment with rounded ends
+class SDFCapsule : public SDFShape {
+	public:
+		SDFCapsule(
+			Point start,		// Centre of one end of capsule
+			Point end,			// Centre of other end of capsule
+			float radius		// Radius of capsule
+		):
+			SDFShape((start + end)/2, start.distance(end)/2 + radius),
+			start(start),
+			axis(end - start),
+			radius(radius) {
+			this->inv_length_squared = 1/(this->axis.x*this->axis.x + this->axis.y*this->axis.y + this->axis.z*this->axis.z);
+		}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			Point p = point - this->start;
+			// Position of closest point along segment (0-1)
+			float h = constrain((p.x*this->axis.x + p.y*this->axis.y + p.z*this->axis.z)*this->inv_length_squared, 0.0f, 1.0f);
+			return (p - this->axis*h).norm() - this->radius;
+		}
+
+		const Point start, axis;
+		const float radius;
+		float inv_length_squared;
+};
+
+// Union of two shapes (inside either shape)
+class SDFUnion : public SDFShape {
+	public:
+		SDFUnion(const SDFShape& a, const SDFShape& b):
+			SDFShape((a.bound_centre + b.bound_centre)/2, sdf_union_radius(a, b, (a.bound_centre + b.bound_centre)/2)),
+			a(a), b(b) {}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			return min(this->a.distance(point, max_distance), this->b.distance(point, max_distance));
+		}
+
+		const SDFShape& a;
+		const SDFShape& b;
+};
+
+// Intersection of two shapes (inside both shapes)
+class SDFIntersect : public SDFShape {
+	public:
+		SDFIntersect(const SDFShape& a, const SDFShape& b):
+			SDFShape(tighter_bounds(a, b).bound_centre, tighter_bounds(a, b).bound_radius),
+			a(a), b(b) {}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			// Outside first shape is outside the intersection
+			float distance_a = this->a.distance(point, max_distance);
+			if (distance_a >= max_distance) {
+				return distance_a;
+			}
+			return max(distance_a, this->b.distance(point, max_distance));
+		}
+
+		// Intersection is inside both bounding spheres, so use the smaller one
+		static const SDFShape& tighter_bounds(const SDFShape& a, const SDFShape& b) {
+			if (a.bound_radius < 0) return b;
+			if (b.bound_radius < 0) return a;
+			return a.bound_radius <= b.bound_radius ? a : b;
+		}
+
+		const SDFShape& a;
+		const SDFShape& b;
+};
+
+// First shape with second shape cut out of it
+class SDFSubtract : public SDFShape {
+	public:
+		SDFSubtract(const SDFShape& a, const SDFShape& b): SDFShape(a.bound_centre, a.bound_radius), a(a), b(b) {}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			float distance_a = this->a.distance(point, max_distance);
+			if (distance_a >= max_distance) {
+				return distance_a;
+			}
+			return max(distance_a, -this->b.distance(point, max_distance));
+		}
+
+		const SDFShape& a;
+		const SDFShape& b;
+};
+
+// Union of two shapes, blended together smoothly where they are within 'smoothing' distance of each other (polynomial smooth min)
+class SDFSmoothUnion : public SDFShape {
+	public:
+		SDFSmoothUnion(
+			const SDFShape& a,
+			const SDFShape& b,
+			float smoothing			// Distance over which the shapes are blended
+		):
+			SDFShape((a.bound_centre + b.bound_centre)/2, smooth_radius(a, b, smoothing)),
+			a(a), b(b), smoothing(smoothing) {}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			// Blending depends on distances up to 'smoothing' further away, so they must not be culled
+			float child_max = max_distance < FLT_MAX ? max_distance + this->smoothing : FLT_MAX;
+			float distance_a = this->a.distance(point, child_max);
+			float distance_b = this->b.distance(point, child_max);
+			float h = max(this->smoothing - fabsf(distance_a - distance_b), 0.0f)/this->smoothing;
+			return min(distance_a, distance_b) - h*h*this->smoothing/4;
+		}
+
+		// Blending extends the surface by up to smoothing/4
+		static float smooth_radius(const SDFShape& a, const SDFShape& b, float smoothing) {
+			float radius = sdf_union_radius(a, b, (a.bound_centre + b.bound_centre)/2);
+			return radius < 0 ? radius : radius + smoothing/4;
+		}
+
+		const SDFShape& a;
+		const SDFShape& b;
+		const float smoothing;
+};
+
+// Shape moved and/or rotated by a rigid transformation (scaling would change distances).
+// The transformation can be changed every frame to animate the shape (e.g. from a subclass of SDFPattern)
+class SDFTransformed : public SDFShape {
+	public:
+		SDFTransformed(
+			const SDFShape& shape,							// Shape to transform
+			const AffineTransform& transform=AffineTransform()	// Transformation of shape (rotation and translation only)
+		): SDFShape(Point(0, 0, 0), -1), shape(shape) {
+			this->setTransform(transform);
+		}
+
+		// Set transformation of shape (rotation and translation only)
+		void setTransform(const AffineTransform& transform) {
+			// Points are transformed into the shape's coordinates with the inverse (transpose of rotation)
+			for (uint8_t row=0; row < 3; row++) {
+				for (uint8_t col=0; col < 3; col++) {
+					this->inverse.m[row][col] = transform.m[col][row];
+				}
+			}
+			this->inverse.translation = -this->inverse.applyLinear(transform.translation);
+		}
+
+	protected:
+		float shapeDistance(const Point& point, float max_distance) const override {
+			return this->shape.distance(this->inverse.apply(point), max_distance);
+		}
+
+		const SDFShape& shape;
+		AffineTransform inverse;		// Transformation from pattern coordinates to shape coordinates
+};
+
+// Draws an SDFShape with colours from a palette ramp on the distance from its surface.
+// The ramp covers distances from -thickness to +thickness, and brightness fades out towards +/-thickness
+// (or only outwards if filled, so the inside of the shape is fully lit). Only points within 'thickness' of the shape
+// are evaluated exactly, so the cost depends on how many LEDs are near the geometry.
+// Subclasses can override frameAction() to animate the shapes (e.g. moving SDFTransformed shapes)
+class SDFPattern : public SizedPattern<SDFPattern, SpatialPattern> {
+	public:
+		SDFPattern(
+			const SDFShape& shape,						// Shape to draw
+			float thickness=32,							// Distance from surface over which colour ramp and fade are applied
+			bool filled=false,							// Whether inside of shape is lit (otherwise only a shell around the surface)
+			uint8_t hue_speed=1,						// Rate that palette ramp moves (hue change per step)
+			const ColorPicker& color_picker=RainbowColors_picker,
+			uint16_t step_time=0						// Time of each step in ms (0 for one step per frame, see StepClock)
+		):
+			SizedPattern(color_picker),
+			shape(shape),
+			thickness(thickness),
+			filled(filled),
+			hue_speed(hue_speed),
+			clock(step_time) {}
+
+		void reset() override {
+			SpatialPattern::reset();
+			this->clock.reset();
+			this->hue_offset = 0;
+		}
+
+		// Subclasses which animate the shapes should override this if the animation is not seekable
+		bool isSeekable() const override {
+			return this->clock.seekable();
+		}
+
+		void frameAction(uint32_t frame_time) override {
+			this->hue_offset = this->clock.update(frame_time)*this->hue_speed;
+		}
+
+		CRGB getPixelValue(Point point) const override {
+			float distance = this->shape.distance(point, this->thickness);
+			if (distance >= this->thickness) {
+				return CRGB::Black;
+			}
+			if (distance <= -this->thickness) {
+				return this->filled ? this->getColor(this->hue_offset) : CRGB::Black;
+			}
+			// Position on palette ramp
+			uint8_t hue = this->hue_offset + (uint8_t) ((distance + this->thickness)*127/this->thickness);
+			float fade = (this->filled && distance < 0) ? 0 : fabsf(distance)/this->thickness;
+			return this->getColor(hue, 255 - (uint8_t) (fade*255));
+		}
+
+	protected:
+		const SDFShape& shape;
+		const float thickness;
+		const bool filled;
+		const uint8_t hue_speed;
+		uint8_t hue_offset=0;
+		StepClock clock;
+};
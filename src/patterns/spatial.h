@@ -1,45 +1,67 @@
 #include <FastLED.h>
 #include "Pattern.h"
 
-class GrowingSpherePattern: public SpatialPattern	{
+class GrowingSpherePattern: public SizedPattern<GrowingSpherePattern, SpatialPattern>	{
 	public:
 		GrowingSpherePattern(
-			uint8_t speed=1,
-			const ColorPicker& color_picker=RainbowColors_picker
-		) : SpatialPattern(color_picker), 
-		speed(speed) {}
+			uint8_t speed=1,					// Change of radius each step
+			const ColorPicker& color_picker=RainbowColors_picker,
+			uint16_t step_time=0				// Time of each step in ms (0 for one step per frame, see StepClock)
+		) : SizedPattern(color_picker), 
+		speed(speed),
+		clock(step_time) {}
 		
 		void reset()	override {
 			SpatialPattern::reset();
+			this->clock.reset();
 			this->radius = 0;
-			this->growing = true;
+		}
+
+		bool isSeekable() const override {
+			return this->clock.seekable();
 		}
 		
 		void frameAction(uint32_t frame_time) override {
-			if (this->growing) {
-				this->radius += this->speed;
-				if (this->radius >= this->resolution)	{
-					this->growing = false;
-				}
-			} else {
-				if (this->radius <= this->speed) {
-					this->growing = true;
-				} else {
-					this->radius -= this->speed;
-				}
-			}
+			this->radius = this->radius_at(this->clock.update(frame_time));
 		};
 		
 		CRGB getPixelValue(Point point) const override { 
-			float point_distance = point.norm();
-			if (point_distance > this->radius) 	{
+			// Compare squared distance first, so sqrt is only needed for points inside the sphere
+			float distance_squared = point.x*point.x + point.y*point.y + point.z*point.z;
+			if (distance_squared > (float) this->radius*this->radius) 	{
 				return CRGB::Black;
 			} else {
-				return this->getColor((255*point_distance)/this->resolution);
+				return this->getColor((255*sqrt(distance_squared))/this->resolution);
 			}
 		}
+
 	private:
+		// Radius after 'step' steps. The sphere grows from 0 until the radius reaches the resolution, shrinks to 'speed', then
+		// repeatedly grows (for at least one step) until the radius reaches the resolution, shrinks to 'speed' and pauses for a step
+		uint16_t radius_at(uint32_t step) const {
+			if (this->speed == 0) {
+				return 0;
+			}
+			// Steps to grow from 0 to full size
+			uint32_t grow_steps = (this->resolution + this->speed - 1)/this->speed;
+			if (step <= grow_steps) {
+				return step*this->speed;
+			}
+			step -= grow_steps;
+			if (step < grow_steps) {
+				return (grow_steps - step)*this->speed;
+			}
+			// Repeating cycle, starting with pause at 'speed'
+			uint32_t cycle_steps = grow_steps < 2 ? 2 : grow_steps;
+			uint32_t phase = (step - grow_steps) % (2*cycle_steps - 1);
+			if (phase < cycle_steps) {
+				return (phase + 1)*this->speed;
+			} else {
+				return (2*cycle_steps - 1 - phase)*this->speed;
+			}
+		}
+
 		const uint8_t speed; 		// Speed at which sphere grows and shrinks
 		uint16_t radius;   	// Current radius of sphere
-		bool growing;		// Whether sphere is growing or shrinking
+		StepClock clock;
 };
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include <FastLED.h>
+#include <Udp.h>
+#include "Pattern.h"
+
+// EXTERNAL STREAM PATTERNS
+// Allow displaying pixel data received from an external sequencer (e.g. xLights, Jinx!, Hyperion, Prismatik)
+// A FrameSource decodes received data directly into the pattern pixel array, which can then be scaled onto strip segments by any linear mapper
+
+// Base class for a source of pixel data received from an external sequencer
+class FrameSource {
+	public:
+		// Receive all pending data, decoding it directly into pixel_data. Return whether any new pixel data was received
+		virtual bool receive(CRGB* pixel_data, uint16_t num_pixels) = 0;
+
+		// Reset receive state
+		virtual void reset() {}
+
+		uint32_t packets=0;				// Number of valid packets received
+		uint32_t dropped_packets=0;		// Number of packets detected as lost (from gaps in sequence numbers)
+};
+
+// Base class for sources which receive DMX universes (512 channels) over UDP, each universe in its own packet
+// Pixels are mapped from RGB channel triplets, starting from 'start_channel' in each universe (so each universe holds (512-start_channel)/3 pixels)
+// The first pixel of 'start_universe' is written to 'pixel_offset' of the pattern pixel array, and following universes continue on from there
+class DMXUDPSource: public FrameSource {
+	public:
+		DMXUDPSource(
+			UDP& udp,						// UDP instance to receive packets from (must already be listening on the protocol port)
+			uint16_t start_universe,		// First universe to receive
+			uint8_t num_universes,			// Number of consecutive universes to receive
+			uint16_t* sequences,			// Array to store last sequence number of each universe (length num_universes)
+			uint16_t start_channel,			// DMX channel offset of the first pixel in each universe (0-based)
+			uint16_t pixel_offset,			// Index of pattern pixel to write first pixel of start_universe to
+			uint16_t sequence_modulus		// Sequence number at which sequence wraps around
+		):
+			udp(udp),
+			start_universe(start_universe),
+			num_universes(num_universes),
+			sequences(sequences),
+			start_channel(start_channel),
+			pixel_offset(pixel_offset),
+			sequence_modulus(sequence_modulus) {}
+
+		void reset() override {
+			for (uint8_t i=0; i < this->num_universes; i++) {
+				this->sequences[i] = NO_SEQUENCE;
+			}
+		}
+
+		bool receive(CRGB* pixel_data, uint16_t num_pixels) override {
+			bool received = false;
+			while (this->udp.parsePacket() > 0) {
+				received |= this->readPacket(pixel_data, num_pixels);
+			}
+			return received;
+		}
+
+	protected:
+		static const uint16_t NO_SEQUENCE = 0xFFFF;		// Value for sequence number which is unknown or not provided by sender
+
+		// Read and validate protocol header of current packet, and get universe, sequence number (or NO_SEQUENCE) and number of DMX channels.
+		// Must leave packet read position at the first DMX channel. Return false if packet is not a DMX data packet
+		virtual bool readHeader(uint16_t& universe, uint16_t& sequence, uint16_t& num_channels) = 0;
+
+		// Read packet and decode DMX channels directly into pixel_data. Return whether pixel data was updated
+		bool readPacket(CRGB* pixel_data, uint16_t num_pixels) {
+			uint16_t universe, sequence, num_channels;
+			if (!this->readHeader(universe, sequence, num_channels)) return false;
+			if (universe < this->start_universe || universe >= this->start_universe + this->num_universes) return false;
+			uint8_t universe_id = universe - this->start_universe;
+			if (!this->checkSequence(universe_id, sequence)) return false;
+			this->packets++;
+
+			if (num_channels > 512) num_channels = 512;
+			if (num_channels <= this->start_channel) return false;
+			this->skip(this->start_channel);
+			uint16_t pixels_per_universe = (512 - this->start_channel)/3;
+			uint32_t first_pixel = this->pixel_offset + (uint32_t) universe_id*pixels_per_universe;
+			if (first_pixel >= num_pixels) return false;
+			uint16_t count = (num_channels - this->start_channel)/3;
+			if (count > num_pixels - first_pixel) count = num_pixels - first_pixel;
+			// CRGB is laid out as RGB bytes, so channels can be read straight into the pixel array
+			this->udp.read((uint8_t*) &pixel_data[first_pixel], count*sizeof(CRGB));
+			return true;
+		}
+
+		// Check sequence number of packet against previous packet of the same universe, and count any dropped packets
+		// Return false if packet is a duplicate or arrived out of order (so should be discarded)
+		bool checkSequence(uint8_t universe_id, uint16_t sequence) {
+			uint16_t prev_sequence = this->sequences[universe_id];
+			if (sequence == NO_SEQUENCE) return true;
+			this->sequences[universe_id] = sequence;
+			if (prev_sequence == NO_SEQUENCE) return true;
+
+			uint16_t diff = (sequence + this->sequence_modulus - prev_sequence) % this->sequence_modulus;
+			if (diff == 0 || diff > this->sequence_modulus - 20) {
+				// Packet is older than previous one (allow for the sender restarting if it is far out of sequence)
+				this->sequences[universe_id] = prev_sequence;
+				return false;
+			}
+			this->dropped_packets += diff - 1;
+			return true;
+		}
+
+		// Discard bytes from current packet
+		void skip(uint16_t num_bytes) {
+			uint8_t scratch[16];
+			while (num_bytes > 0) {
+				uint16_t chunk = num_bytes > sizeof(scratch) ? sizeof(scratch) : num_bytes;
+				this->udp.read(scratch, chunk);
+				num_bytes -= chunk;
+			}
+		}
+
+		UDP& udp;
+		const uint16_t start_universe;
+		const uint8_t num_universes;
+		uint16_t* sequences;
+		const uint16_t start_channel, pixel_offset, sequence_modulus;
+};
+
+// Receive pixel data from Art-Net (ArtDmx packets, UDP port 6454)
+// Template parameter is the number of consecutive universes to receive
+template<uint8_t t_num_universes>
+class ArtNetSource: public DMXUDPSource {
+	public:
+		ArtNetSource(
+			UDP& udp,						// UDP instance listening on port 6454
+			uint16_t start_universe=0,		// First universe (15-bit Port-Address) to receive
+			uint16_t start_channel=0,		// DMX channel offset of the first pixel in each universe (0-based)
+			uint16_t pixel_offset=0			// Index of pattern pixel to write first pixel of start_universe to
+		): DMXUDPSource(udp, start_universe, t_num_universes, universe_sequences, start_channel, pixel_offset, 255) {
+			this->reset();
+		}
+
+	protected:
+		bool readHeader(uint16_t& universe, uint16_t& sequence, uint16_t& num_channels) override {
+			uint8_t header[18];
+			if (this->udp.read(header, sizeof(header)) != sizeof(header)) return false;
+			// ID "Art-Net", OpCode 0x5000 (OpDmx, little endian)
+			if (memcmp(header, "Art-Net", 8) != 0 || header[8] != 0x00 || header[9] != 0x50) return false;
+			// Sequence 0 means sequencing is disabled, otherwise runs from 1-255
+			sequence = header[12] ? header[12] - 1 : NO_SEQUENCE;
+			universe = ((header[15] & 0x7F) << 8) | header[14];
+			num_channels = (header[16] << 8) | header[17];
+			return true;
+		}
+
+		uint16_t universe_sequences[t_num_universes];	// Last sequence number of each universe
+};
+
+// Receive pixel data from E1.31 (Streaming ACN, UDP port 5568)
+// Template parameter is the number of consecutive universes to receive
+template<uint8_t t_num_universes>
+class E131Source: public DMXUDPSource {
+	public:
+		E131Source(
+			UDP& udp,						// UDP instance listening on port 5568 (and joined to multicast groups if required)
+			uint16_t start_universe=1,		// First universe to receive
+			uint16_t start_channel=0,		// DMX channel offset of the first pixel in each universe (0-based)
+			uint16_t pixel_offset=0			// Index of pattern pixel to write first pixel of start_universe to
+		): DMXUDPSource(udp, start_universe, t_num_universes, universe_sequences, start_channel, pixel_offset, 256) {
+			this->reset();
+		}
+
+	protected:
+		bool readHeader(uint16_t& universe, uint16_t& sequence, uint16_t& num_channels) override {
+			uint8_t header[126];
+			if (this->udp.read(header, sizeof(header)) != sizeof(header)) return false;
+			// ACN packet identifier, root vector VECTOR_ROOT_E131_DATA, framing vector VECTOR_E131_DATA_PACKET, DMP vector and DMX start code 0
+			if (memcmp(&header[4], "ASC-E1.17", 9) != 0 || header[21] != 0x04 || header[43] != 0x02 ||
+				header[117] != 0x02 || header[125] != 0x00) return false;
+			// Stream terminated option bit
+			if (header[112] & 0x40) return false;
+			sequence = header[111];
+			universe = (header[113] << 8) | header[114];
+			// Property value count includes start code
+			num_channels = ((header[123] << 8) | header[124]) - 1;
+			return true;
+		}
+
+		uint16_t universe_sequences[t_num_universes];	// Last sequence number of each universe
+};
+
+// Receive pixel data from Adalight protocol over serial (as used by Prismatik, Hyperion, etc)
+// Frame format is "Ada", LED count - 1 (high byte, low byte), checksum (high ^ low ^ 0x55), followed by RGB bytes for each LED
+// Data is decoded directly into the pixel array as it arrives, so a frame can be partially updated if it has not been
+// completely received by the time the pattern frame is rendered. Adalight does not provide sequence numbers, so dropped frames are not detected
+class AdalightSource: public FrameSource {
+	public:
+		AdalightSource(
+			Stream& serial				// Serial port to receive data from (must already be initialised)
+		): serial(serial) {}
+
+		void reset() override {
+			this->state = 0;
+		}
+
+		bool receive(CRGB* pixel_data, uint16_t num_pixels) override {
+			bool received = false;
+			uint8_t* data = (uint8_t*) pixel_data;
+			uint32_t data_size = (uint32_t) num_pixels*sizeof(CRGB);
+			while (this->serial.available() > 0) {
+				uint8_t value = this->serial.read();
+				switch (this->state) {
+					case 0: case 1: case 2:
+						// Magic word
+						if (value == "Ada"[this->state]) {
+							this->state++;
+						} else {
+							this->state = (value == 'A') ? 1 : 0;
+						}
+						break;
+					case 3: case 4:
+						this->header[this->state - 3] = value;
+						this->state++;
+						break;
+					case 5:
+						if (value == (this->header[0] ^ this->header[1] ^ 0x55)) {
+							this->data_len = (((uint32_t) this->header[0] << 8) + this->header[1] + 1)*sizeof(CRGB);
+							this->data_pos = 0;
+							this->state++;
+						} else {
+							this->state = 0;
+						}
+						break;
+					default:
+						if (this->data_pos < data_size) {
+							data[this->data_pos] = value;
+						}
+						this->data_pos++;
+						if (this->data_pos == this->data_len) {
+							this->packets++;
+							received = true;
+							this->state = 0;
+						}
+				}
+			}
+			return received;
+		}
+
+	protected:
+		Stream& serial;
+		uint8_t state=0;				// Decoder state (0-2: magic word, 3-5: header, 6: pixel data)
+		uint8_t header[2];				// LED count high and low bytes
+		uint32_t data_len, data_pos;	// Length of pixel data in frame, and number of bytes received
+};
+
+// Displays pixel data received from an external sequencer through a FrameSource
+// Holds the last received frame if no new data arrives, and optionally blacks out after a timeout
+// Use with a LinearPatternMapper to scale the stream onto strip segments, with resolution equal to the number of streamed pixels
+class ExternalStreamPattern: public SizedPattern<ExternalStreamPattern, LinearPattern> {
+	public:
+		ExternalStreamPattern(
+			FrameSource& source,		// Source of pixel data
+			uint16_t hold_time=0		// Time to hold last frame after data stops before blacking out (in ms, 0 to hold forever)
+		):
+			SizedPattern(),
+			source(source),
+			hold_time(hold_time) {}
+
+		void reset() override {
+			LinearPattern::reset();
+			this->source.reset();
+			this->last_receive_time = 0;
+			this->blacked_out = false;
+		}
+
+		void frameAction(CRGB* pixel_data, uint16_t num_pixels, uint32_t frame_time) override {
+			if (this->source.receive(pixel_data, num_pixels)) {
+				this->last_receive_time = frame_time;
+				this->blacked_out = false;
+			} else if (this->hold_time && (frame_time - this->last_receive_time) > this->hold_time) {
+				fill_solid(pixel_data, num_pixels, CRGB::Black);
+				this->blacked_out = true;
+			}
+		}
+
+		LayerState getLayerState() const override {
+			return this->blacked_out ? LAYER_EMPTY : LAYER_PARTIAL;
+		}
+
+	protected:
+		FrameSource& source;
+		const uint16_t hold_time;
+		uint32_t last_receive_time=0;	// Frame time that data was last received
+		bool blacked_out=false;			// Whether pixels have been blacked out after hold_time
+};
@@ -12,6 +12,15 @@
 // Limit maximum value
 #define limit(x, max) (x > max ? max : x)
 
+// Function which provides the current time in ms. Used by MappingRunner so that rendering can be driven 
+// by a clock other than millis() (e.g. a simulated clock for deterministic off-device rendering)
+typedef uint32_t (*TimeSource)();
+
+// Default time source (wall-clock time since boot)
+uint32_t system_millis() {
+	return millis();
+}
+
 // Used for interpolating values on a linear gradient determined by two provided points
 class Interpolator	{
 	public:
@@ -39,6 +48,16 @@ uint16_t wrap_subtract(uint16_t value, uint16_t subtract, uint16_t max_value)	{
 	}
 }
 
+// Greatest common divisor of a and b
+uint32_t greatest_common_divisor(uint32_t a, uint32_t b) {
+	while (b != 0) {
+		uint32_t r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
 // Get a new random number from 0-255, but with a minimum distance away from the previous one
 uint8_t new_random_value8(uint8_t old_value, uint8_t min_distance=42)  {
   uint8_t r = 0, x = 0, y = 0, d = 0;
@@ -73,7 +92,10 @@ uint8_t attackDecayWave8( uint8_t i)
   }
 }
 
-#ifdef __arm__
+#if defined(__unix__) || defined(__APPLE__)
+// Host build (including ARM Linux), where unistd.h declares sbrk
+#include <unistd.h>
+#elif defined(__arm__)
 // should use uinstd.h to define sbrk but Due causes a conflict
 extern "C" char* sbrk(int incr);
 #else  // __ARM__
@@ -82,7 +104,7 @@ extern char *__brkval;
 
 int freeMemory() {
   char top;
-#ifdef __arm__
+#if defined(__arm__) || defined(__unix__) || defined(__APPLE__)
   return &top - reinterpret_cast<char*>(sbrk(0));
 #elif defined(CORE_TEENSY) || (ARDUINO > 103 && ARDUINO != 151)
   return &top - __brkval;